@@ -0,0 +1,82 @@
+#include "ast/expression.hpp"
+#include "semant/inheritance_graph.hpp"
+#include "symbol/symbol.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+coolc::Symbol ClassName(std::size_t index) {
+  std::string name = "H";
+  name += std::to_string(index);
+  return coolc::Symbol::Intern(name);
+}
+
+/// class H<i> inherits H<(i - 1) / fanout>, so fanout 1 is a chain of the given depth and larger fanouts are wide
+/// trees of logarithmic depth
+coolc::Program Hierarchy(std::size_t size, std::size_t fanout) {
+  coolc::Program program;
+  for (std::size_t i = 0; i < size; ++i) {
+    coolc::Class cl;
+    cl.type = ClassName(i);
+    cl.inherits_type = i == 0 ? coolc::symbols::kObject : ClassName((i - 1) / fanout);
+    program.classes.push_back(std::move(cl));
+  }
+  coolc::Class main;
+  main.type = coolc::symbols::kMain;
+  main.inherits_type = coolc::symbols::kIO;
+  program.classes.push_back(std::move(main));
+  return program;
+}
+
+/// random pairs of the classes of the program, the same for every run
+std::vector<std::pair<coolc::Symbol, coolc::Symbol>> Pairs(const coolc::Program& program) {
+  std::mt19937 random{1};
+  std::vector<std::pair<coolc::Symbol, coolc::Symbol>> pairs(1024);
+  for (auto& [left, right] : pairs) {
+    left = program.classes[random() % program.classes.size()].type;
+    right = program.classes[random() % program.classes.size()].type;
+  }
+  return pairs;
+}
+
+void BM_IsAncessor(benchmark::State& state) {
+  auto program = Hierarchy(static_cast<std::size_t>(state.range(0)), static_cast<std::size_t>(state.range(1)));
+  coolc::InheritanceGraph graph;
+  graph.FillAndCheck(program);
+  auto pairs = Pairs(program);
+  for (auto _ : state) {
+    std::size_t conforming = 0;
+    for (auto [base, derived] : pairs) {
+      conforming += graph.IsAncessor(base, derived);
+    }
+    benchmark::DoNotOptimize(conforming);
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(pairs.size()));
+}
+
+void BM_GetLca(benchmark::State& state) {
+  auto program = Hierarchy(static_cast<std::size_t>(state.range(0)), static_cast<std::size_t>(state.range(1)));
+  coolc::InheritanceGraph graph;
+  graph.FillAndCheck(program);
+  auto pairs = Pairs(program);
+  for (auto _ : state) {
+    for (auto [left, right] : pairs) {
+      benchmark::DoNotOptimize(graph.GetLca(left, right));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(pairs.size()));
+}
+
+/// the second argument is the fanout, 1 gives chains
+BENCHMARK(BM_IsAncessor)->ArgsProduct({{1 << 6, 1 << 9, 1 << 12}, {1, 8}});
+BENCHMARK(BM_GetLca)->ArgsProduct({{1 << 6, 1 << 9, 1 << 12}, {1, 8}});
+
+}  // namespace
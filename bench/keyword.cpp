@@ -0,0 +1,98 @@
+#include "lexer/lexer.hpp"
+#include "token/token.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+using coolc::Token;
+
+/// identifiers and keywords in the proportion they appear in examples/*.cl
+constexpr std::array<std::string_view, 16> kWords{"class",  "x",    "inherits", "IO",     "let",  "tRUE",
+                                                  "String", "else", "out_string", "Fi",   "count", "isvoid",
+                                                  "self",   "then", "ELSE",     "length"};
+
+/// Regex and hash map lookup, the way identifiers were recognized before the perfect hash
+Token::Type RegexKeyword(const std::string& word) {
+  static const std::unordered_map<std::string, Token::Type> from_str{
+      {"class", Token::Type::Class}, {"in", Token::Type::In},       {"loop", Token::Type::Loop},
+      {"pool", Token::Type::Pool},   {"if", Token::Type::If},       {"true", Token::Type::True},
+      {"false", Token::Type::False}, {"else", Token::Type::Else},   {"inherits", Token::Type::Inherits},
+      {"while", Token::Type::While}, {"case", Token::Type::Case},   {"fi", Token::Type::Fi},
+      {"isvoid", Token::Type::Isvoid}, {"esac", Token::Type::Esac}, {"new", Token::Type::New},
+      {"of", Token::Type::Of},       {"not", Token::Type::Not},     {"then", Token::Type::Then},
+      {"let", Token::Type::Let}};
+  std::regex reg(R"(^(class|if|else|fi|inherits|in|isvoid|loop|pool|true|false|while|case|esac|new|of|not|then|let)$)",
+                 std::regex_constants::icase);
+  if (!std::regex_match(word, reg)) {
+    return Token::Type::Unknown;
+  }
+  std::string lower = word;
+  std::for_each(lower.begin(), lower.end(), [](char& el) { el = std::tolower(el); });
+  auto type = from_str.at(lower);
+  if ((type == Token::Type::True || type == Token::Type::False) && !std::islower(word[0])) {
+    return Token::Type::Unknown;
+  }
+  return type;
+}
+
+void BM_RegexKeyword(benchmark::State& state) {
+  std::array<std::string, kWords.size()> words;
+  std::copy(kWords.begin(), kWords.end(), words.begin());
+  for (auto _ : state) {
+    for (const auto& word : words) {
+      benchmark::DoNotOptimize(RegexKeyword(word));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * words.size());
+}
+BENCHMARK(BM_RegexKeyword);
+
+void BM_PerfectHashKeyword(benchmark::State& state) {
+  for (auto _ : state) {
+    for (auto word : kWords) {
+      benchmark::DoNotOptimize(Token::KeywordFromString(word));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kWords.size());
+}
+BENCHMARK(BM_PerfectHashKeyword);
+
+void BM_PunctuatorFromChar(benchmark::State& state) {
+  constexpr std::string_view chars = "{}();:+-*/~<=.,@abc";
+  for (auto _ : state) {
+    for (auto ch : chars) {
+      benchmark::DoNotOptimize(Token::PunctuatorFromChar(ch));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * chars.size());
+}
+BENCHMARK(BM_PunctuatorFromChar);
+
+/// whole identifier path of the lexer, one token per word
+void BM_LexIdentifiers(benchmark::State& state) {
+  std::string source;
+  for (int i = 0; i < 1024; ++i) {
+    for (auto word : kWords) {
+      source.append(word).push_back(' ');
+    }
+  }
+  std::size_t tokens = 0;
+  for (auto _ : state) {
+    auto result = coolc::Lexer(std::string_view{source}).Tokenize();
+    tokens += result.size();
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(tokens);
+}
+BENCHMARK(BM_LexIdentifiers);
+
+}  // namespace
@@ -0,0 +1,129 @@
+#include "lexer/lexer.hpp"
+#include "util/util.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+std::atomic<std::size_t> allocations{0};
+
+}  // namespace
+
+/// every allocation of the process is counted, so the cost of the lexer can be reported per token.
+/// Not inlined, otherwise gcc pairs new expressions with the malloc and free inside and reports a mismatch.
+__attribute__((noinline)) void* operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* result = std::malloc(std::max<std::size_t>(size, 1))) {
+    return result;
+  }
+  throw std::bad_alloc{};
+}
+
+__attribute__((noinline)) void operator delete(void* pointer) noexcept {
+  std::free(pointer);
+}
+
+__attribute__((noinline)) void operator delete(void* pointer, std::size_t) noexcept {
+  std::free(pointer);
+}
+
+namespace {
+
+/// contents of the files with the extension in the directory, in the order of names
+std::vector<std::string> ReadCorpus(const std::filesystem::path& directory, std::string_view extension) {
+  std::vector<std::filesystem::path> paths;
+  for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+    if (entry.path().extension() == extension) {
+      paths.push_back(entry.path());
+    }
+  }
+  std::sort(paths.begin(), paths.end());
+  std::vector<std::string> sources;
+  for (const auto& path : paths) {
+    sources.push_back(ReadAllFile(path.string()));
+  }
+  return sources;
+}
+
+/// pattern repeated up to size bytes, cut at the end of a repetition
+std::string Repeat(std::string_view pattern, std::size_t size) {
+  std::string result;
+  result.reserve(size + pattern.size());
+  while (result.size() < size) {
+    result.append(pattern);
+  }
+  return result;
+}
+
+/// Tokenizes every source once per iteration in the zero-copy mode.
+/// Reports bytes and tokens per second and heap allocations per token.
+void TokenizeAll(benchmark::State& state, const std::vector<std::string>& sources) {
+  std::size_t bytes = 0;
+  std::size_t tokens = 0;
+  for (const auto& source : sources) {
+    bytes += source.size();
+    tokens += coolc::Lexer(std::string_view{source}).Tokenize().size();
+  }
+  auto allocations_before = allocations.load(std::memory_order_relaxed);
+  for (auto _ : state) {
+    for (const auto& source : sources) {
+      auto buffer = coolc::Lexer(std::string_view{source}).Tokenize();
+      benchmark::DoNotOptimize(buffer.size());
+    }
+  }
+  auto allocated = allocations.load(std::memory_order_relaxed) - allocations_before;
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * bytes));
+  state.counters["tokens/s"] = benchmark::Counter(static_cast<double>(tokens),
+                                                  benchmark::Counter::kIsIterationInvariantRate);
+  state.counters["allocs/token"] =
+      static_cast<double>(allocated) / static_cast<double>(std::max<std::size_t>(state.iterations() * tokens, 1));
+}
+
+void BM_Examples(benchmark::State& state) {
+  static const auto sources = ReadCorpus(COOLC_SOURCE_DIR "/examples", ".cl");
+  TokenizeAll(state, sources);
+}
+BENCHMARK(BM_Examples);
+
+/// mostly error cases: unterminated strings and comments, invalid characters
+void BM_E2ELexerCorpus(benchmark::State& state) {
+  static const auto sources = ReadCorpus(COOLC_SOURCE_DIR "/test/e2e/lexer", ".cl");
+  TokenizeAll(state, sources);
+}
+BENCHMARK(BM_E2ELexerCorpus);
+
+/// synthetic input of state.range(0) bytes
+void BM_Synthetic(benchmark::State& state, std::string_view pattern) {
+  TokenizeAll(state, {Repeat(pattern, static_cast<std::size_t>(state.range(0)))});
+}
+
+BENCHMARK_CAPTURE(BM_Synthetic, CommentHeavy,
+                  "(* a block comment (* with a nested one *) spanning\n   several lines *)\n"
+                  "-- and a line comment\nx <- 1;\n")
+    ->Arg(1 << 16)
+    ->Arg(1 << 22);
+BENCHMARK_CAPTURE(BM_Synthetic, StringHeavy,
+                  "s <- \"a string literal with \\t escapes, \\\"quotes\\\" and a few more words\";\n")
+    ->Arg(1 << 16)
+    ->Arg(1 << 22);
+BENCHMARK_CAPTURE(BM_Synthetic, LongIdentifiers,
+                  "an_identifier_which_is_much_longer_than_the_usual_ones_in_cool_programs <- "
+                  "AnotherVeryLongTypeIdentifierWithCamelCaseWordsForTheBenchmark;\n")
+    ->Arg(1 << 16)
+    ->Arg(1 << 22);
+BENCHMARK_CAPTURE(BM_Synthetic, NoWhitespace, "x<-a+b*(c-d)/e;if@f.g(h,i)<=j;{k=>l~m}")
+    ->Arg(1 << 16)
+    ->Arg(1 << 22);
+
+}  // namespace
@@ -0,0 +1,165 @@
+#include "ast/expression.hpp"
+#include "ast/flat_ast.hpp"
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+#include "token/token_buffer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <string_view>
+
+#include <malloc.h>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+std::atomic<std::size_t> live_bytes{0};
+std::atomic<std::size_t> peak_bytes{0};
+
+}  // namespace
+
+/// every allocation of the process is tracked, so the peak heap of a parse can be reported.
+/// Not inlined, otherwise gcc pairs new expressions with the malloc and free inside and reports a mismatch.
+__attribute__((noinline)) void* operator new(std::size_t size) {
+  if (void* result = std::malloc(std::max<std::size_t>(size, 1))) {
+    auto live = live_bytes.fetch_add(malloc_usable_size(result), std::memory_order_relaxed) +
+                malloc_usable_size(result);
+    auto peak = peak_bytes.load(std::memory_order_relaxed);
+    while (live > peak && !peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+    return result;
+  }
+  throw std::bad_alloc{};
+}
+
+__attribute__((noinline)) void operator delete(void* pointer) noexcept {
+  live_bytes.fetch_sub(malloc_usable_size(pointer), std::memory_order_relaxed);
+  std::free(pointer);
+}
+
+__attribute__((noinline)) void operator delete(void* pointer, std::size_t) noexcept {
+  live_bytes.fetch_sub(malloc_usable_size(pointer), std::memory_order_relaxed);
+  std::free(pointer);
+}
+
+namespace {
+
+/// method main of class Main with the body
+std::string InMain(std::string_view body) {
+  return "class Main inherits IO {\n  main() : Object {\n" + std::string{body} + "\n  };\n};\n";
+}
+
+std::string Repeat(std::string_view pattern, std::size_t times) {
+  std::string result;
+  result.reserve(pattern.size() * times);
+  for (std::size_t i = 0; i < times; ++i) {
+    result.append(pattern);
+  }
+  return result;
+}
+
+std::string Classes(std::size_t count) {
+  std::string result;
+  for (std::size_t i = 0; i < count; ++i) {
+    std::string name = "C";
+    name += std::to_string(i);
+    result += "class " + name + " inherits IO {\n  x : Int <- " + std::to_string(i) + ";\n  f(a : Int) : " + name +
+              " { { x <- x + a; self; } };\n};\n";
+  }
+  return result;
+}
+
+std::string Features(std::size_t count) {
+  std::string result = "class Main inherits IO {\n";
+  for (std::size_t i = 0; i < count; i += 2) {
+    auto index = std::to_string(i);
+    result += "  a" + index + " : Int <- " + index + ";\n  m" + index + "(x : Int) : Int { x * a" + index + " };\n";
+  }
+  return result + "};\n";
+}
+
+std::string LetChain(std::size_t depth) {
+  std::string body;
+  for (std::size_t i = 0; i < depth; ++i) {
+    body += "let x" + std::to_string(i) + " : Int <- " + std::to_string(i) + " in\n";
+  }
+  return InMain(body + "x0");
+}
+
+std::string NestedIf(std::size_t depth) {
+  return InMain(Repeat("if true then ", depth) + "1" + Repeat(" else 2 fi", depth));
+}
+
+std::string NestedWhile(std::size_t depth) {
+  return InMain(Repeat("while true loop ", depth) + "1" + Repeat(" pool", depth));
+}
+
+/// one long left-associative chain of the ParseAddSub loop
+std::string AddChain(std::size_t length) {
+  std::string body = "0";
+  for (std::size_t i = 1; i < length; ++i) {
+    body += (i % 2 == 0 ? " + " : " - ") + std::to_string(i);
+  }
+  return InMain(body);
+}
+
+/// every other call is a static dispatch, the parser takes @ only after a primary, so its receiver is parenthesized
+std::string DispatchChain(std::size_t length) {
+  std::string body = "self";
+  for (std::size_t i = 0; i < length; ++i) {
+    body = i % 2 == 0 ? "(" + body + ")@IO.out_int(" + std::to_string(i) + ")" : body + ".out_string(\"x\")";
+  }
+  return InMain(body);
+}
+
+/// Parses the tokens of the source once per iteration, lexing is not measured.
+/// Reports nodes per second, arena bytes per node and the peak heap growth of a parse per node.
+void ParseAll(benchmark::State& state, const std::string& source) {
+  auto tokens = coolc::Lexer(std::string_view{source}).Tokenize();
+  std::size_t nodes = 0;
+  std::size_t arena_bytes = 0;
+  std::size_t peak = 0;
+  {
+    auto before = live_bytes.load(std::memory_order_relaxed);
+    peak_bytes.store(before, std::memory_order_relaxed);
+    auto program = coolc::Parser(tokens, "bench.cl").ParseProgram();
+    peak = peak_bytes.load(std::memory_order_relaxed) - before;
+    arena_bytes = program.arena->MemoryUsage();
+    nodes = coolc::FlatAst::FromProgram(program).Nodes().size();
+  }
+  for (auto _ : state) {
+    auto program = coolc::Parser(tokens, "bench.cl").ParseProgram();
+    benchmark::DoNotOptimize(program.classes.data());
+  }
+  auto per_node = [&](std::size_t bytes) {
+    return static_cast<double>(bytes) / static_cast<double>(std::max<std::size_t>(nodes, 1));
+  };
+  state.SetComplexityN(static_cast<std::int64_t>(nodes));
+  state.counters["nodes"] = static_cast<double>(nodes);
+  state.counters["nodes/s"] =
+      benchmark::Counter(static_cast<double>(nodes), benchmark::Counter::kIsIterationInvariantRate);
+  state.counters["arena bytes/node"] = per_node(arena_bytes);
+  state.counters["peak bytes/node"] = per_node(peak);
+}
+
+template <std::string (*Generate)(std::size_t)>
+void BM_Axis(benchmark::State& state) {
+  ParseAll(state, Generate(static_cast<std::size_t>(state.range(0))));
+}
+
+// the nested axes stop where the recursive FlatAst::FromProgram used for counting nodes still fits the stack
+BENCHMARK_TEMPLATE(BM_Axis, Classes)->RangeMultiplier(4)->Range(1 << 6, 1 << 14)->Complexity(benchmark::oN);
+BENCHMARK_TEMPLATE(BM_Axis, Features)->RangeMultiplier(4)->Range(1 << 6, 1 << 16)->Complexity(benchmark::oN);
+BENCHMARK_TEMPLATE(BM_Axis, LetChain)->RangeMultiplier(4)->Range(1 << 4, 1 << 12)->Complexity(benchmark::oN);
+BENCHMARK_TEMPLATE(BM_Axis, NestedIf)->RangeMultiplier(4)->Range(1 << 4, 1 << 12)->Complexity(benchmark::oN);
+BENCHMARK_TEMPLATE(BM_Axis, NestedWhile)->RangeMultiplier(4)->Range(1 << 4, 1 << 12)->Complexity(benchmark::oN);
+BENCHMARK_TEMPLATE(BM_Axis, AddChain)->RangeMultiplier(4)->Range(1 << 6, 1 << 14)->Complexity(benchmark::oN);
+BENCHMARK_TEMPLATE(BM_Axis, DispatchChain)->RangeMultiplier(4)->Range(1 << 4, 1 << 12)->Complexity(benchmark::oN);
+
+}  // namespace
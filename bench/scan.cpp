@@ -0,0 +1,55 @@
+#include "lexer/scan.hpp"
+#include "util/util.hpp"
+
+#include <cstdint>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+using coolc::scan::Kernels;
+
+/// walks the whole file as if it was one big comment, the hot loop of Lexer::SkipComment
+void BM_CommentScan(benchmark::State& state, const Kernels* kernels) {
+  const auto source = ReadAllFile(COOLC_SOURCE_DIR "/examples/cool.cl");
+  auto end = source.data() + source.size();
+  for (auto _ : state) {
+    std::uint32_t delimiters = 0;
+    for (auto curr = kernels->find_comment_delimiter(source.data(), end); curr != end;
+         curr = kernels->find_comment_delimiter(curr + 1, end)) {
+      ++delimiters;
+    }
+    benchmark::DoNotOptimize(delimiters);
+  }
+  state.SetBytesProcessed(state.iterations() * source.size());
+}
+
+/// alternates whitespace and word runs over the whole file
+void BM_WhitespaceAndWords(benchmark::State& state, const Kernels* kernels) {
+  const auto source = ReadAllFile(COOLC_SOURCE_DIR "/examples/cool.cl");
+  auto end = source.data() + source.size();
+  for (auto _ : state) {
+    std::uint32_t lines = 0;
+    for (auto curr = source.data(); curr != end;) {
+      curr = kernels->skip_whitespace(curr, end, &lines);
+      auto word_end = kernels->find_word_end(curr, end);
+      curr = word_end == curr && curr != end ? curr + 1 : word_end;
+    }
+    benchmark::DoNotOptimize(lines);
+  }
+  state.SetBytesProcessed(state.iterations() * source.size());
+}
+
+const bool registered = [] {
+  for (const auto* kernels : {&coolc::scan::ScalarKernels(), coolc::scan::Sse2Kernels(), coolc::scan::Avx2Kernels()}) {
+    if (kernels) {
+      benchmark::RegisterBenchmark((std::string{"BM_CommentScan/"} + kernels->name).c_str(), BM_CommentScan, kernels);
+      benchmark::RegisterBenchmark((std::string{"BM_WhitespaceAndWords/"} + kernels->name).c_str(),
+                                   BM_WhitespaceAndWords, kernels);
+    }
+  }
+  return true;
+}();
+
+}  // namespace
@@ -0,0 +1,131 @@
+#include "gen/program_generator.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+namespace {
+
+constexpr std::string_view kUsage =
+    "usage: coolgen [options] > program.cl\n"
+    "  --seed N                 random seed, the same options and seed give the same program\n"
+    "  --classes N              minimal number of classes\n"
+    "  --size N[K|M|G]          keep adding classes until the program has at least N bytes\n"
+    "  --inheritance-depth N    maximal depth of inheritance chains\n"
+    "  --fanout N               number of direct subclasses of a class, 0 for no inheritance\n"
+    "  --methods N              methods per class\n"
+    "  --attributes N           attributes per class\n"
+    "  --expression-depth N     depth of method bodies\n"
+    "  --dispatch W, --let W, --case W, --string W\n"
+    "                           relative weights of dispatches, lets, cases and string expressions\n"
+    "  --error-every N          put one error into every N-th class\n"
+    "  --errors KIND            syntax, semantic or mixed\n"
+    "  -o FILE                  write to the file instead of stdout\n"
+    "  --help                   print this message\n";
+
+/// number with an optional binary K, M or G suffix
+bool ParseSize(std::string_view text, std::size_t* result) {
+  std::size_t multiplier = 1;
+  if (!text.empty()) {
+    switch (text.back()) {
+      case 'K':
+        multiplier = std::size_t{1} << 10;
+        break;
+      case 'M':
+        multiplier = std::size_t{1} << 20;
+        break;
+      case 'G':
+        multiplier = std::size_t{1} << 30;
+        break;
+    }
+    if (multiplier != 1) {
+      text.remove_suffix(1);
+    }
+  }
+  if (text.empty() || text.find_first_not_of("0123456789") != std::string_view::npos) {
+    return false;
+  }
+  *result = std::stoull(std::string{text}) * multiplier;
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  coolc::gen::Options options;
+  std::string output;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view flag = argv[i];
+    if (flag == "--help") {
+      std::cout << kUsage;
+      return 0;
+    }
+    if (i + 1 == argc) {
+      std::cerr << "error: " << flag << " needs a value\n" << kUsage;
+      return 1;
+    }
+    std::string_view value = argv[++i];
+    std::size_t number = 0;
+    bool is_number = ParseSize(value, &number);
+    auto weight = static_cast<unsigned>(number);
+    if (flag == "-o") {
+      output = value;
+    } else if (flag == "--errors") {
+      if (value == "syntax") {
+        options.errors = coolc::gen::ErrorKind::Syntax;
+      } else if (value == "semantic") {
+        options.errors = coolc::gen::ErrorKind::Semantic;
+      } else if (value == "mixed") {
+        options.errors = coolc::gen::ErrorKind::Mixed;
+      } else {
+        std::cerr << "error: unknown kind of errors " << value << "\n" << kUsage;
+        return 1;
+      }
+    } else if (!is_number) {
+      std::cerr << "error: " << flag << " needs a number, got " << value << "\n" << kUsage;
+      return 1;
+    } else if (flag == "--seed") {
+      options.seed = number;
+    } else if (flag == "--classes") {
+      options.classes = number;
+    } else if (flag == "--size") {
+      options.min_bytes = number;
+    } else if (flag == "--inheritance-depth") {
+      options.inheritance_depth = number;
+    } else if (flag == "--fanout") {
+      options.fanout = number;
+    } else if (flag == "--methods") {
+      options.methods = number;
+    } else if (flag == "--attributes") {
+      options.attributes = number;
+    } else if (flag == "--expression-depth") {
+      options.expression_depth = number;
+    } else if (flag == "--dispatch") {
+      options.dispatch_weight = weight;
+    } else if (flag == "--let") {
+      options.let_weight = weight;
+    } else if (flag == "--case") {
+      options.case_weight = weight;
+    } else if (flag == "--string") {
+      options.string_weight = weight;
+    } else if (flag == "--error-every") {
+      options.error_every = number;
+    } else {
+      std::cerr << "error: unknown option " << flag << "\n" << kUsage;
+      return 1;
+    }
+  }
+
+  coolc::gen::ProgramGenerator generator{options};
+  if (output.empty()) {
+    std::ios::sync_with_stdio(false);
+    generator.Generate(std::cout);
+    return std::cout.flush() ? 0 : 1;
+  }
+  std::ofstream os{output, std::ios::binary};
+  generator.Generate(os);
+  return os.flush() ? 0 : 1;
+}
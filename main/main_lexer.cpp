@@ -1,6 +1,8 @@
 #include "ast/expression.hpp"
 #include "lexer/lexer.hpp"
+#include "token/string_literal.hpp"
 #include "token/token.hpp"
+#include "util/thread_pool.hpp"
 #include "util/util.hpp"
 
 #include <filesystem>
@@ -21,7 +23,11 @@ std::ostream& operator<<(std::ostream& os, const coolc::Token& token) {
     if (token.type == coolc::Token::Type::String || token.type == coolc::Token::Type::Unknown) {
       os << "\"";
     }
-    os << *token.lexeme;
+    if (token.type == coolc::Token::Type::String) {
+      os << coolc::EscapeStringLiteral(token.lexeme->View());
+    } else {
+      os << *token.lexeme;
+    }
     if (token.type == coolc::Token::Type::String || token.type == coolc::Token::Type::Unknown) {
       os << "\"";
     }
@@ -38,9 +44,10 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
+  coolc::util::ThreadPool pool;
   for (int i = 1; i < argc; ++i) {
     coolc::Lexer lexer(ReadAllFile(argv[i]));
-    auto tokens = lexer.Tokenize();
+    auto tokens = lexer.Tokenize(pool);
     std::cout << "#name \"" << argv[i] << '\"' << std::endl;
     for (const auto& el : tokens) {
       std::cout << el;
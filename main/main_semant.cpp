@@ -1,12 +1,12 @@
 #include "ast/expression.hpp"
-#include "lexer/lexer.hpp"
-#include "parser/parser.hpp"
 #include "semant/inheritance_graph.hpp"
 #include "semant/semant.hpp"
+#include "util/thread_pool.hpp"
 #include "util/type_traits.hpp"
 #include "util/util.hpp"
 
 #include <iostream>
+#include <utility>
 
 int main(int argc, char* argv[]) {
   if (argc < 2) {
@@ -14,14 +14,16 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
+  coolc::util::ThreadPool pool;
   for (int i = 1; i < argc; ++i) {
-    coolc::Lexer lexer(ReadAllFile(argv[i]));
-    auto tokens = lexer.Tokenize();
-    auto program = coolc::Parser(tokens, argv[i]).ParseProgram();
+    auto program = ParseFile(argv[i]);
+    if (!program) {
+      return 1;
+    }
 
-    coolc::Semant semantic_checker(std::move(program));
+    coolc::Semant semantic_checker(std::move(*program));
 
-    if (!semantic_checker.CheckProgram()) {
+    if (!semantic_checker.CheckProgram(pool)) {
       std::cerr << "Compilation halted due to static semantic errors." << std::endl;
       return 1;
     }
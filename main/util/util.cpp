@@ -1,7 +1,21 @@
+#include "util/util.hpp"
+
+#include "ast/ast_cache.hpp"
+#include "ast/expression.hpp"
+#include "lexer/lexer.hpp"
+#include "lexer/token_pipeline.hpp"
+#include "parser/parser.hpp"
+
+#include <cstdlib>
 #include <filesystem>
 #include <fstream>
+#include <iostream>
+#include <optional>
 #include <string>
 
+#include <fcntl.h>
+#include <unistd.h>
+
 std::string ReadAllFile(std::string filename) {
   std::ifstream is(std::filesystem::path{filename});
   if (!is.is_open()) {
@@ -9,3 +23,51 @@ std::string ReadAllFile(std::string filename) {
   }
   return std::string(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
 }
+
+int OpenFile(std::string filename) {
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error{"File" + filename + "does not exist"};
+  }
+  return fd;
+}
+
+namespace {
+
+/// the lexer runs on its own thread, ahead of the parser
+std::optional<coolc::Program> Parse(coolc::Lexer& lexer, const std::string& filename) {
+  coolc::TokenPipeline pipeline{lexer};
+  coolc::Parser parser(pipeline.Stream(), filename, coolc::Parser::ErrorMode::Recover);
+  auto program = parser.ParseProgram();
+  if (!parser.Diagnostics().empty()) {
+    parser.PrintDiagnostics(std::cerr);
+    std::cerr << "Compilation halted due to lex and parse errors" << std::endl;
+    return std::nullopt;
+  }
+  return program;
+}
+
+}  // namespace
+
+std::optional<coolc::Program> ParseFile(const std::string& filename) {
+  const char* cache_directory = std::getenv("COOLC_AST_CACHE");
+  if (cache_directory == nullptr || *cache_directory == '\0') {
+    int fd = OpenFile(filename);
+    auto lexer = coolc::Lexer::FromFileDescriptor(fd);
+    auto program = Parse(lexer, filename);
+    close(fd);
+    return program;
+  }
+
+  coolc::AstCache cache{cache_directory};
+  auto source = ReadAllFile(filename);
+  if (auto program = cache.Load(filename, source)) {
+    return program;
+  }
+  coolc::Lexer lexer{std::string_view{source}};
+  auto program = Parse(lexer, filename);
+  if (program) {
+    cache.Store(filename, source, *program);
+  }
+  return program;
+}
@@ -1,3 +1,16 @@
 #pragma once
 
+#include "ast/expression.hpp"
+
+#include <optional>
+#include <string>
+
 std::string ReadAllFile(std::string filename);
+
+/// Opens file for reading, the caller closes the descriptor
+int OpenFile(std::string filename);
+
+/// Parses the file, syntax errors are printed to stderr and give nullopt.
+/// If COOLC_AST_CACHE names a directory, the program is loaded from there when the source is unchanged since it was
+/// stored, so the file is not lexed and parsed; programs parsed without errors are stored there.
+std::optional<coolc::Program> ParseFile(const std::string& filename);
@@ -0,0 +1,65 @@
+#include "ast/ast_cache.hpp"
+
+#include "ast/expression.hpp"
+#include "ast/flat_ast.hpp"
+#include "util/hash.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include <unistd.h>
+
+namespace coolc {
+
+AstCache::AstCache(std::filesystem::path directory) : _directory{std::move(directory)} {
+}
+
+std::optional<Program> AstCache::Load(const std::string& filename, std::string_view source) const {
+  std::ifstream is{EntryPath(filename), std::ios::binary};
+  if (!is) {
+    return std::nullopt;
+  }
+  std::string image{std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>()};
+  auto ast = FlatAst::Deserialize(image, util::Fnv1a(source));
+  if (!ast) {
+    return std::nullopt;
+  }
+  return ast->ToProgram();
+}
+
+void AstCache::Store(const std::string& filename, std::string_view source, const Program& program) const {
+  auto image = FlatAst::FromProgram(program).Serialize(util::Fnv1a(source));
+  std::error_code error;
+  std::filesystem::create_directories(_directory, error);
+  auto path = EntryPath(filename);
+  auto temporary = path;
+  temporary += ".";
+  temporary += std::to_string(::getpid());
+  temporary += ".tmp";
+  {
+    std::ofstream os{temporary, std::ios::binary | std::ios::trunc};
+    if (!os.write(image.data(), static_cast<std::streamsize>(image.size()))) {
+      std::filesystem::remove(temporary, error);
+      return;
+    }
+  }
+  std::filesystem::rename(temporary, path, error);
+  if (error) {
+    std::filesystem::remove(temporary, error);
+  }
+}
+
+std::filesystem::path AstCache::EntryPath(const std::string& filename) const {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.ast", static_cast<unsigned long long>(util::Fnv1a(filename)));
+  return _directory / name;
+}
+
+}  // namespace coolc
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "ast/expression.hpp"
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace coolc {
+
+/// Directory of binary images of parsed programs, one entry per source file name.
+/// An entry records the hash of the source it was made from and is used only while the source is unchanged.
+/// A hit reads the whole entry and rebuilds the tree from it in a new arena, which saves lexing and parsing but not
+/// the allocation of the nodes. Entries are written to a temporary file which is renamed over the entry, so
+/// concurrent compilers never see a partially written image.
+class AstCache {
+ public:
+  explicit AstCache(std::filesystem::path directory);
+
+  /// Program of the entry of filename if it was stored for the same source, nullopt on a miss
+  std::optional<Program> Load(const std::string& filename, std::string_view source) const;
+
+  /// Stores program parsed from source, errors are ignored as the cache is only a shortcut
+  void Store(const std::string& filename, std::string_view source, const Program& program) const;
+
+ private:
+  std::filesystem::path EntryPath(const std::string& filename) const;
+
+  std::filesystem::path _directory;
+};
+
+}  // namespace coolc
@@ -1,9 +1,12 @@
 #pragma once
 
+#include "symbol/symbol.hpp"
+#include "util/arena.hpp"
 #include "util/type_traits.hpp"
 
 #include <memory>
 #include <optional>
+#include <span>
 #include <string>
 #include <variant>
 #include <vector>
@@ -24,8 +27,8 @@ struct LineNumbered {
  * Program parts:
  */
 struct TypedId : LineNumbered {
-  std::string type_id;
-  std::string object_id;
+  Symbol type_id;
+  Symbol object_id;
 };
 
 /// Formal = Id : Type
@@ -34,12 +37,12 @@ struct Formal : TypedId {};
 /// Method = Id ([Formal]*) : Type { expr }
 struct Method : TypedId {
   std::vector<Formal> formals;
-  std::shared_ptr<Expression> expr;
+  Expression* expr{nullptr};
 };
 
 /// Attribute = Id : Type [ <- expr ]
 struct Attribute : TypedId {
-  std::shared_ptr<Expression> expr;
+  Expression* expr{nullptr};
 };
 
 /// Feature = Method | Attribute
@@ -49,26 +52,29 @@ struct Feature {
 
 /// Class = class Type [ inherits Type ] { [Feature]* }
 struct Class : LineNumbered {
-  std::string type;
-  std::string inherits_type;
+  Symbol type;
+  Symbol inherits_type;
   std::vector<Feature> features;
   std::string filename;
 };
 
 /// Program = [Class]+
+/// Expressions of the program are allocated in its arena and freed together with it.
 struct Program : LineNumbered {
   std::vector<Class> classes;
+  std::unique_ptr<util::Arena> arena;
 };
 
 /**
  * Expressions classes
+ * Children are pointers and spans into the arena of the program, so nodes are trivially destructible.
  */
 
 struct Empty : LineNumbered {};
 
 /// Unary expressions
 struct UnaryExpressionBase : LineNumbered {
-  std::shared_ptr<Expression> arg;
+  Expression* arg{nullptr};
 };
 
 template <typename T>
@@ -80,8 +86,8 @@ struct Not : UnaryExpressionBase {};
 
 /// Binary expressions
 struct BinaryExpressionBase : LineNumbered {
-  std::shared_ptr<Expression> lhs;
-  std::shared_ptr<Expression> rhs;
+  Expression* lhs{nullptr};
+  Expression* rhs{nullptr};
 };
 
 template <typename T>
@@ -101,7 +107,8 @@ struct Int : LineNumbered {
 };
 
 struct String : LineNumbered {
-  std::string value;
+  /// raw text between the quotes, see DecodeStringLiteral
+  Symbol value;
 };
 
 struct Bool : LineNumbered {
@@ -113,48 +120,48 @@ concept IsBasicT = util::IsOneOfV<T, Bool, String, Int>;
 
 /// Other
 struct If : LineNumbered {
-  std::shared_ptr<Expression> condition;
-  std::shared_ptr<Expression> then_expr;
-  std::shared_ptr<Expression> else_expr;
+  Expression* condition{nullptr};
+  Expression* then_expr{nullptr};
+  Expression* else_expr{nullptr};
 };
 
 struct While : LineNumbered {
-  std::shared_ptr<Expression> condition;
-  std::shared_ptr<Expression> loop_body;
+  Expression* condition{nullptr};
+  Expression* loop_body{nullptr};
 };
 
 struct Id : LineNumbered {
-  std::string name;
+  Symbol name;
 };
 
 struct Assign : LineNumbered {
-  std::string identifier;
-  std::shared_ptr<Expression> rhs;
+  Symbol identifier;
+  Expression* rhs{nullptr};
 };
 
 struct New : LineNumbered {
-  std::string type;
+  Symbol type;
 };
 
 struct Dispatch : LineNumbered {
-  std::shared_ptr<Expression> expr;
-  std::optional<std::string> type_id;
-  std::shared_ptr<Id> object_id;
-  std::vector<std::shared_ptr<Expression>> parameters;
+  Expression* expr{nullptr};
+  std::optional<Symbol> type_id;
+  Id* object_id{nullptr};
+  std::span<Expression*> parameters;
 };
 
 struct Let : LineNumbered {
-  std::shared_ptr<Expression> expr;
-  std::vector<Attribute> attrs;
+  Expression* expr{nullptr};
+  std::span<Attribute> attrs;
 };
 
 struct Case : LineNumbered {
-  std::shared_ptr<Expression> expr;
-  std::vector<Attribute> cases;
+  Expression* expr{nullptr};
+  std::span<Attribute> cases;
 };
 
 struct Block : LineNumbered {
-  std::vector<std::shared_ptr<Expression>> expr;
+  std::span<Expression*> expr;
 };
 
 template <typename T>
@@ -181,7 +188,7 @@ struct Expression {
                Id, New, Dispatch, Assign, If, While, Case, Let, Block>
       data_{Empty{}};
 
-  std::string type{"_no_type"};
+  Symbol type{symbols::kNoType};
 
   template <typename T>
   requires ExpressionT<std::remove_cvref_t<T>> Expression(T&& data) : data_{std::forward<T>(data)} {
@@ -203,4 +210,6 @@ struct Expression {
   }
 };
 
+static_assert(std::is_trivially_destructible_v<Expression>);
+
 }  // namespace coolc
@@ -0,0 +1,701 @@
+#include "ast/flat_ast.hpp"
+
+#include "ast/expression.hpp"
+#include "symbol/symbol.hpp"
+#include "util/arena.hpp"
+#include "util/type_traits.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace coolc {
+
+/// Emits expressions of a tree in post-order. The tree is walked with an explicit stack, so the depth of an
+/// expression is not limited by the native stack.
+class FlatAst::Builder {
+ public:
+  explicit Builder(FlatAst* ast) : _ast{ast} {
+  }
+
+  Index Build(const Expression& root) {
+    // a frame is visited twice: first its children are pushed, then it is emitted after all of them
+    struct Frame {
+      const Expression* expr;
+      std::uint32_t children;
+      bool visited;
+    };
+    std::vector<Frame> frames{{&root, 0, false}};
+    std::vector<const Expression*> children;
+    while (!frames.empty()) {
+      if (auto& frame = frames.back(); !frame.visited) {
+        children.clear();
+        Children(*frame.expr, &children);
+        frame.children = static_cast<std::uint32_t>(children.size());
+        frame.visited = true;
+        for (auto it = children.rbegin(); it != children.rend(); ++it) {
+          frames.push_back({*it, 0, false});
+        }
+        continue;
+      }
+      auto frame = frames.back();
+      frames.pop_back();
+      auto first = _built.end() - frame.children;
+      auto index = Emit(*frame.expr, std::span<const Index>{first, _built.end()});
+      _built.erase(first, _built.end());
+      _built.push_back(index);
+    }
+    auto index = _built.back();
+    _built.pop_back();
+    return index;
+  }
+
+ private:
+  /// children of the expression in the order they are emitted
+  static void Children(const Expression& expr, std::vector<const Expression*>* children) {
+    auto bindings = [&](const auto& e, std::span<const Attribute> attributes) {
+      // bindings are emitted before the body, as they are in scope of it
+      for (const auto& binding : attributes) {
+        children->push_back(binding.expr);
+      }
+      children->push_back(e.expr);
+    };
+    // clang-format off
+    std::visit(util::Overloaded{
+        [&](const UnaryExpressionT auto& e) { children->push_back(e.arg); },
+        [&](const BinaryExpressionT auto& e) { children->insert(children->end(), {e.lhs, e.rhs}); },
+        [&](const Assign& e) { children->push_back(e.rhs); },
+        [&](const While& e) { children->insert(children->end(), {e.condition, e.loop_body}); },
+        [&](const If& e) { children->insert(children->end(), {e.condition, e.then_expr, e.else_expr}); },
+        [&](const Block& e) { children->insert(children->end(), e.expr.begin(), e.expr.end()); },
+        [&](const Dispatch& e) {
+          children->push_back(e.expr);
+          children->insert(children->end(), e.parameters.begin(), e.parameters.end());
+        },
+        [&](const Let& e) { bindings(e, e.attrs); },
+        [&](const Case& e) { bindings(e, e.cases); },
+        [](const auto&) {}},
+        expr.data_);
+    // clang-format on
+  }
+
+  /// pushes the node of the expression, children are the indices of the nodes of its Children
+  Index Emit(const Expression& expr, std::span<const Index> c) {
+    // clang-format off
+    auto visitor = util::Overloaded{
+        [&](const Empty& e) { return Push(Kind::Empty, e); },
+        [&](const Inversion& e) { return Push(Kind::Inversion, e, c[0]); },
+        [&](const IsVoid& e) { return Push(Kind::IsVoid, e, c[0]); },
+        [&](const Not& e) { return Push(Kind::Not, e, c[0]); },
+        [&](const Plus& e) { return Push(Kind::Plus, e, c[0], c[1]); },
+        [&](const Mul& e) { return Push(Kind::Mul, e, c[0], c[1]); },
+        [&](const Div& e) { return Push(Kind::Div, e, c[0], c[1]); },
+        [&](const Sub& e) { return Push(Kind::Sub, e, c[0], c[1]); },
+        [&](const Less& e) { return Push(Kind::Less, e, c[0], c[1]); },
+        [&](const LessEq& e) { return Push(Kind::LessEq, e, c[0], c[1]); },
+        [&](const Equal& e) { return Push(Kind::Equal, e, c[0], c[1]); },
+        [&](const Int& e) {
+          _ast->_ints.push_back(e.value);
+          return Push(Kind::Int, e, static_cast<Index>(_ast->_ints.size() - 1));
+        },
+        [&](const String& e) { return Push(Kind::String, e, _ast->PushSymbol(e.value)); },
+        [&](const Bool& e) { return Push(Kind::Bool, e, e.value ? 1 : 0); },
+        [&](const Id& e) { return Push(Kind::Id, e, _ast->PushSymbol(e.name)); },
+        [&](const New& e) { return Push(Kind::New, e, _ast->PushSymbol(e.type)); },
+        [&](const Assign& e) { return Push(Kind::Assign, e, _ast->PushSymbol(e.identifier), c[0]); },
+        [&](const While& e) { return Push(Kind::While, e, c[0], c[1]); },
+        [&](const If& e) { return Push(Kind::If, e, _ast->PushExtra({c[0], c[1], c[2]})); },
+        [&](const Block& e) { return Push(Kind::Block, e, PushExtra(c), static_cast<Index>(c.size())); },
+        [&](const Dispatch& e) {
+          auto arguments = c.subspan(1);
+          auto type_id = e.type_id ? _ast->PushSymbol(*e.type_id) : kNone;
+          auto first = _ast->PushExtra({c[0], type_id, _ast->PushSymbol(e.object_id->name),
+                                        static_cast<Index>(e.object_id->line_number),
+                                        static_cast<Index>(arguments.size())});
+          PushExtra(arguments);
+          return Push(Kind::Dispatch, e, first);
+        },
+        [&](const Let& e) { return PushBindings(Kind::Let, e, e.attrs, c); },
+        [&](const Case& e) { return PushBindings(Kind::Case, e, e.cases, c); }};
+    // clang-format on
+    auto index = std::visit(visitor, expr.data_);
+    _ast->_types[index] = expr.type;
+    return index;
+  }
+
+  Index Push(Kind kind, const LineNumbered& expr, Index lhs = kNone, Index rhs = kNone) {
+    return _ast->Push(kind, expr.line_number, lhs, rhs);
+  }
+
+  template <typename T>
+  Index PushBindings(Kind kind, const T& expr, std::span<const Attribute> bindings, std::span<const Index> c) {
+    auto first = _ast->PushExtra({c.back(), static_cast<Index>(bindings.size())});
+    for (std::size_t i = 0; i < bindings.size(); ++i) {
+      _ast->PushExtra({static_cast<Index>(bindings[i].line_number), _ast->PushSymbol(bindings[i].object_id),
+                       _ast->PushSymbol(bindings[i].type_id), c[i]});
+    }
+    return Push(kind, expr, first);
+  }
+
+  Index PushExtra(std::span<const Index> values) {
+    auto first = static_cast<Index>(_ast->_extra.size());
+    _ast->_extra.insert(_ast->_extra.end(), values.begin(), values.end());
+    return first;
+  }
+
+  FlatAst* _ast;
+  /// indices of the emitted expressions whose parents are not emitted yet
+  std::vector<Index> _built;
+};
+
+FlatAst FlatAst::FromProgram(const Program& program) {
+  FlatAst ast;
+  ast._line = static_cast<std::uint32_t>(program.line_number);
+  Builder builder{&ast};
+  for (const auto& cl : program.classes) {
+    ast._classes.push_back({.line = static_cast<std::uint32_t>(cl.line_number),
+                            .type = cl.type,
+                            .inherits_type = cl.inherits_type,
+                            .filename = cl.filename,
+                            .first_feature = static_cast<Index>(ast._features.size()),
+                            .feature_count = static_cast<Index>(cl.features.size())});
+    for (const auto& feature : cl.features) {
+      // clang-format off
+      ast._features.push_back(std::visit(util::Overloaded{
+          [&](const Method& m) {
+            auto first_formal = static_cast<Index>(ast._formals.size());
+            ast._formals.insert(ast._formals.end(), m.formals.begin(), m.formals.end());
+            return Feature{.is_method = true, .line = static_cast<std::uint32_t>(m.line_number),
+                           .object_id = m.object_id, .type_id = m.type_id, .first_formal = first_formal,
+                           .formal_count = static_cast<Index>(m.formals.size()), .body = builder.Build(*m.expr)};
+          },
+          [&](const Attribute& a) {
+            return Feature{.is_method = false, .line = static_cast<std::uint32_t>(a.line_number),
+                           .object_id = a.object_id, .type_id = a.type_id,
+                           .first_formal = static_cast<Index>(ast._formals.size()), .formal_count = 0,
+                           .body = builder.Build(*a.expr)};
+          }},
+          feature.feature));
+      // clang-format on
+    }
+  }
+  return ast;
+}
+
+Program FlatAst::ToProgram() const {
+  Program program;
+  program.line_number = _line;
+  program.arena = std::make_unique<util::Arena>();
+  // children precede their parents, so one pass in the order of the nodes expands every expression
+  std::vector<Expression*> expanded(_nodes.size(), nullptr);
+  for (Index index = 0; index < _nodes.size(); ++index) {
+    expanded[index] = Expand(index, expanded, program.arena.get());
+  }
+  program.classes.reserve(_classes.size());
+  for (const auto& cl : _classes) {
+    coolc::Class& result = program.classes.emplace_back();
+    result.line_number = cl.line;
+    result.type = cl.type;
+    result.inherits_type = cl.inherits_type;
+    result.filename = cl.filename;
+    for (const auto& feature : Features(cl)) {
+      if (feature.is_method) {
+        Method method;
+        method.line_number = feature.line;
+        method.object_id = feature.object_id;
+        method.type_id = feature.type_id;
+        auto formals = Formals(feature);
+        method.formals.assign(formals.begin(), formals.end());
+        method.expr = expanded[feature.body];
+        result.features.push_back({std::move(method)});
+      } else {
+        Attribute attribute;
+        attribute.line_number = feature.line;
+        attribute.object_id = feature.object_id;
+        attribute.type_id = feature.type_id;
+        attribute.expr = expanded[feature.body];
+        result.features.push_back({attribute});
+      }
+    }
+  }
+  return program;
+}
+
+Expression* FlatAst::Expand(Index index, std::span<Expression* const> expanded, util::Arena* arena) const {
+  const auto& node = _nodes[index];
+  auto line = node.line;
+  auto make = [&](auto data) {
+    auto* expr = arena->New<Expression>(std::move(data));
+    expr->type = _types[index];
+    return expr;
+  };
+  auto expand_all = [&](std::span<const Index> children) {
+    std::vector<Expression*> result;
+    result.reserve(children.size());
+    for (auto child : children) {
+      result.push_back(expanded[child]);
+    }
+    return arena->NewArray<Expression*>(result);
+  };
+  auto expand_bindings = [&](Index first, std::size_t count) {
+    std::vector<Attribute> bindings(count);
+    for (std::size_t i = 0; i < count; ++i) {
+      auto binding = GetExtra(first + 4 * i, 4);
+      bindings[i].line_number = binding[0];
+      bindings[i].object_id = _symbols[binding[1]];
+      bindings[i].type_id = _symbols[binding[2]];
+      bindings[i].expr = expanded[binding[3]];
+    }
+    return arena->NewArray<Attribute>(bindings);
+  };
+
+  switch (node.kind) {
+    case Kind::Empty:
+      break;
+    case Kind::Inversion:
+      return make(Inversion{line, expanded[node.lhs]});
+    case Kind::IsVoid:
+      return make(IsVoid{line, expanded[node.lhs]});
+    case Kind::Not:
+      return make(Not{line, expanded[node.lhs]});
+    case Kind::Plus:
+      return make(Plus{line, expanded[node.lhs], expanded[node.rhs]});
+    case Kind::Mul:
+      return make(Mul{line, expanded[node.lhs], expanded[node.rhs]});
+    case Kind::Div:
+      return make(Div{line, expanded[node.lhs], expanded[node.rhs]});
+    case Kind::Sub:
+      return make(Sub{line, expanded[node.lhs], expanded[node.rhs]});
+    case Kind::Less:
+      return make(Less{line, expanded[node.lhs], expanded[node.rhs]});
+    case Kind::LessEq:
+      return make(LessEq{line, expanded[node.lhs], expanded[node.rhs]});
+    case Kind::Equal:
+      return make(Equal{line, expanded[node.lhs], expanded[node.rhs]});
+    case Kind::Int:
+      return make(Int{line, _ints[node.lhs]});
+    case Kind::String:
+      return make(String{line, _symbols[node.lhs]});
+    case Kind::Bool:
+      return make(Bool{line, node.lhs != 0});
+    case Kind::Id:
+      return make(Id{line, _symbols[node.lhs]});
+    case Kind::New:
+      return make(New{line, _symbols[node.lhs]});
+    case Kind::Assign:
+      return make(Assign{line, _symbols[node.lhs], expanded[node.rhs]});
+    case Kind::While:
+      return make(While{line, expanded[node.lhs], expanded[node.rhs]});
+    case Kind::If: {
+      auto operands = GetExtra(node.lhs, 3);
+      return make(If{line, expanded[operands[0]], expanded[operands[1]], expanded[operands[2]]});
+    }
+    case Kind::Block:
+      return make(Block{line, expand_all(GetExtra(node.lhs, node.rhs))});
+    case Kind::Dispatch: {
+      auto operands = GetExtra(node.lhs, 5);
+      Dispatch dispatch;
+      dispatch.line_number = line;
+      dispatch.expr = expanded[operands[0]];
+      if (operands[1] != kNone) {
+        dispatch.type_id = _symbols[operands[1]];
+      }
+      dispatch.object_id = arena->New<Id>(Id{operands[3], _symbols[operands[2]]});
+      dispatch.parameters = expand_all(GetExtra(node.lhs + 5, operands[4]));
+      return make(dispatch);
+    }
+    case Kind::Let: {
+      auto operands = GetExtra(node.lhs, 2);
+      return make(Let{line, expanded[operands[0]], expand_bindings(node.lhs + 2, operands[1])});
+    }
+    case Kind::Case: {
+      auto operands = GetExtra(node.lhs, 2);
+      return make(Case{line, expanded[operands[0]], expand_bindings(node.lhs + 2, operands[1])});
+    }
+  }
+  return make(Empty{line});
+}
+
+namespace {
+
+constexpr char kImageMagic[8] = {'C', 'O', 'O', 'L', 'A', 'S', 'T', '\0'};
+constexpr std::uint32_t kByteOrderMark = 0x01020304;
+
+/// Fixed part of an image, followed by the arrays in the order of the counts and then by the bytes of the strings
+struct ImageHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byte_order;
+  std::uint64_t source_hash;
+  std::uint32_t line;
+  std::uint32_t strings;
+  std::uint32_t string_bytes;
+  std::uint32_t nodes;
+  std::uint32_t symbols;
+  std::uint32_t ints;
+  std::uint32_t extra;
+  std::uint32_t classes;
+  std::uint32_t features;
+  std::uint32_t formals;
+};
+
+/// Nodes are written field by field in their layout in memory, so that the padding after the kind is written as zeros
+/// and the same tree always gives the same image
+constexpr std::size_t kNodePadding = offsetof(FlatAst::Node, line) - sizeof(FlatAst::Kind);
+static_assert(offsetof(FlatAst::Node, lhs) == offsetof(FlatAst::Node, line) + sizeof(std::uint32_t));
+static_assert(offsetof(FlatAst::Node, rhs) == offsetof(FlatAst::Node, lhs) + sizeof(FlatAst::Index));
+static_assert(sizeof(FlatAst::Node) == offsetof(FlatAst::Node, rhs) + sizeof(FlatAst::Index));
+
+/// Records of the classes, features and formals: every field is a 32-bit word, symbols are string indices
+constexpr std::size_t kClassWords = 6;
+constexpr std::size_t kFeatureWords = 7;
+constexpr std::size_t kFormalWords = 3;
+
+class ImageWriter {
+ public:
+  template <typename T>
+  void Write(const T& value) {
+    WriteArray<T>(std::span{&value, 1});
+  }
+
+  template <typename T>
+  void WriteArray(std::span<const T> values) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    _image.append(reinterpret_cast<const char*>(values.data()), values.size_bytes());
+  }
+
+  std::string Take() {
+    return std::move(_image);
+  }
+
+ private:
+  std::string _image;
+};
+
+/// Bounds checked reads from an image, the image may be unaligned so values are copied out
+class ImageReader {
+ public:
+  explicit ImageReader(std::string_view image) : _image{image} {
+  }
+
+  template <typename T>
+  bool ReadArray(std::size_t count, std::vector<T>* values) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    if (count > (_image.size() - _pos) / sizeof(T)) {
+      return false;
+    }
+    values->resize(count);
+    std::memcpy(values->data(), _image.data() + _pos, count * sizeof(T));
+    _pos += count * sizeof(T);
+    return true;
+  }
+
+  template <typename T>
+  bool Read(T* value) {
+    if (sizeof(T) > _image.size() - _pos) {
+      return false;
+    }
+    std::memcpy(value, _image.data() + _pos, sizeof(T));
+    _pos += sizeof(T);
+    return true;
+  }
+
+  std::optional<std::string_view> ReadBytes(std::size_t count) {
+    if (count > _image.size() - _pos) {
+      return std::nullopt;
+    }
+    auto bytes = _image.substr(_pos, count);
+    _pos += count;
+    return bytes;
+  }
+
+ private:
+  std::string_view _image;
+  std::size_t _pos{0};
+};
+
+}  // namespace
+
+std::string FlatAst::Serialize(std::uint64_t source_hash) const {
+  std::vector<Symbol> strings;
+  std::unordered_map<Symbol, std::uint32_t> string_index;
+  auto intern = [&](Symbol symbol) {
+    auto [it, inserted] = string_index.try_emplace(symbol, static_cast<std::uint32_t>(strings.size()));
+    if (inserted) {
+      strings.push_back(symbol);
+    }
+    return it->second;
+  };
+  auto intern_all = [&](std::span<const Symbol> symbols) {
+    std::vector<std::uint32_t> indices;
+    indices.reserve(symbols.size());
+    for (auto symbol : symbols) {
+      indices.push_back(intern(symbol));
+    }
+    return indices;
+  };
+
+  auto types = intern_all(_types);
+  auto symbols = intern_all(_symbols);
+  std::vector<std::uint32_t> classes;
+  classes.reserve(_classes.size() * kClassWords);
+  for (const auto& cl : _classes) {
+    classes.insert(classes.end(), {cl.line, intern(cl.type), intern(cl.inherits_type),
+                                   intern(Symbol::Intern(cl.filename)), cl.first_feature, cl.feature_count});
+  }
+  std::vector<std::uint32_t> features;
+  features.reserve(_features.size() * kFeatureWords);
+  for (const auto& feature : _features) {
+    features.insert(features.end(), {feature.is_method ? 1u : 0u, feature.line, intern(feature.object_id),
+                                     intern(feature.type_id), feature.first_formal, feature.formal_count,
+                                     feature.body});
+  }
+  std::vector<std::uint32_t> formals;
+  formals.reserve(_formals.size() * kFormalWords);
+  for (const auto& formal : _formals) {
+    formals.insert(formals.end(), {static_cast<std::uint32_t>(formal.line_number), intern(formal.object_id),
+                                   intern(formal.type_id)});
+  }
+
+  std::vector<std::uint32_t> string_offsets{0};
+  std::string string_bytes;
+  for (auto symbol : strings) {
+    string_bytes += symbol.View();
+    string_offsets.push_back(static_cast<std::uint32_t>(string_bytes.size()));
+  }
+
+  ImageHeader header{};
+  std::memcpy(header.magic, kImageMagic, sizeof(kImageMagic));
+  header.version = kImageVersion;
+  header.byte_order = kByteOrderMark;
+  header.source_hash = source_hash;
+  header.line = _line;
+  header.strings = static_cast<std::uint32_t>(strings.size());
+  header.string_bytes = static_cast<std::uint32_t>(string_bytes.size());
+  header.nodes = static_cast<std::uint32_t>(_nodes.size());
+  header.symbols = static_cast<std::uint32_t>(_symbols.size());
+  header.ints = static_cast<std::uint32_t>(_ints.size());
+  header.extra = static_cast<std::uint32_t>(_extra.size());
+  header.classes = static_cast<std::uint32_t>(_classes.size());
+  header.features = static_cast<std::uint32_t>(_features.size());
+  header.formals = static_cast<std::uint32_t>(_formals.size());
+
+  ImageWriter writer;
+  writer.Write(header);
+  writer.WriteArray<std::uint32_t>(string_offsets);
+  for (const auto& node : _nodes) {
+    writer.Write(node.kind);
+    writer.Write(std::array<char, kNodePadding>{});
+    writer.Write(node.line);
+    writer.Write(node.lhs);
+    writer.Write(node.rhs);
+  }
+  writer.WriteArray<std::uint32_t>(types);
+  writer.WriteArray<std::uint32_t>(symbols);
+  writer.WriteArray<std::int32_t>(_ints);
+  writer.WriteArray<Index>(_extra);
+  writer.WriteArray<std::uint32_t>(classes);
+  writer.WriteArray<std::uint32_t>(features);
+  writer.WriteArray<std::uint32_t>(formals);
+  writer.WriteArray<char>(string_bytes);
+  return writer.Take();
+}
+
+std::optional<FlatAst> FlatAst::Deserialize(std::string_view image, std::uint64_t source_hash) {
+  ImageReader reader{image};
+  ImageHeader header;
+  if (!reader.Read(&header) || std::memcmp(header.magic, kImageMagic, sizeof(kImageMagic)) != 0 ||
+      header.version != kImageVersion || header.byte_order != kByteOrderMark || header.source_hash != source_hash) {
+    return std::nullopt;
+  }
+
+  FlatAst ast;
+  ast._line = header.line;
+  std::vector<std::uint32_t> string_offsets, types, symbols, classes, features, formals;
+  if (!reader.ReadArray(std::size_t{header.strings} + 1, &string_offsets) ||
+      !reader.ReadArray(header.nodes, &ast._nodes) || !reader.ReadArray(header.nodes, &types) ||
+      !reader.ReadArray(header.symbols, &symbols) || !reader.ReadArray(header.ints, &ast._ints) ||
+      !reader.ReadArray(header.extra, &ast._extra) ||
+      !reader.ReadArray(std::size_t{header.classes} * kClassWords, &classes) ||
+      !reader.ReadArray(std::size_t{header.features} * kFeatureWords, &features) ||
+      !reader.ReadArray(std::size_t{header.formals} * kFormalWords, &formals)) {
+    return std::nullopt;
+  }
+  auto string_bytes = reader.ReadBytes(header.string_bytes);
+  if (!string_bytes) {
+    return std::nullopt;
+  }
+
+  // strings are interned once, then symbol indices are mapped to the symbols
+  std::vector<Symbol> strings;
+  strings.reserve(header.strings);
+  for (std::size_t i = 0; i < header.strings; ++i) {
+    if (string_offsets[i] > string_offsets[i + 1] || string_offsets[i + 1] > string_bytes->size()) {
+      return std::nullopt;
+    }
+    auto length = string_offsets[i + 1] - string_offsets[i];
+    strings.push_back(Symbol::Intern(string_bytes->substr(string_offsets[i], length)));
+  }
+  bool valid = true;
+  auto symbol = [&](std::uint32_t index) {
+    valid &= index < strings.size();
+    return valid ? strings[index] : Symbol{};
+  };
+  auto map_symbols = [&](const std::vector<std::uint32_t>& indices, std::vector<Symbol>* result) {
+    result->reserve(indices.size());
+    for (auto index : indices) {
+      result->push_back(symbol(index));
+    }
+  };
+  map_symbols(types, &ast._types);
+  map_symbols(symbols, &ast._symbols);
+
+  ast._classes.reserve(header.classes);
+  for (std::size_t i = 0; i < classes.size(); i += kClassWords) {
+    const auto* words = &classes[i];
+    valid &= words[4] <= header.features && words[5] <= header.features - words[4];
+    ast._classes.push_back({.line = words[0],
+                            .type = symbol(words[1]),
+                            .inherits_type = symbol(words[2]),
+                            .filename = symbol(words[3]).Str(),
+                            .first_feature = words[4],
+                            .feature_count = words[5]});
+  }
+  ast._features.reserve(header.features);
+  for (std::size_t i = 0; i < features.size(); i += kFeatureWords) {
+    const auto* words = &features[i];
+    valid &= words[4] <= header.formals && words[5] <= header.formals - words[4] && words[6] < header.nodes;
+    ast._features.push_back({.is_method = words[0] != 0,
+                             .line = words[1],
+                             .object_id = symbol(words[2]),
+                             .type_id = symbol(words[3]),
+                             .first_formal = words[4],
+                             .formal_count = words[5],
+                             .body = words[6]});
+  }
+  ast._formals.resize(header.formals);
+  for (std::size_t i = 0; i < ast._formals.size(); ++i) {
+    const auto* words = &formals[i * kFormalWords];
+    ast._formals[i].line_number = words[0];
+    ast._formals[i].object_id = symbol(words[1]);
+    ast._formals[i].type_id = symbol(words[2]);
+  }
+  for (Index index = 0; valid && index < ast._nodes.size(); ++index) {
+    valid = ast.IsValid(index);
+  }
+  if (!valid) {
+    return std::nullopt;
+  }
+  return ast;
+}
+
+bool FlatAst::IsValid(Index index) const {
+  const auto& node = _nodes[index];
+  // children precede their parents, which ToProgram relies on, so a damaged image cannot make a cycle
+  auto child = [index](Index operand) { return operand < index; };
+  auto symbol = [this](Index operand) { return operand < _symbols.size(); };
+  auto extra = [this](Index first, std::size_t count) {
+    return first <= _extra.size() && count <= _extra.size() - first;
+  };
+  auto children = [&](Index first, std::size_t count) {
+    return extra(first, count) && std::ranges::all_of(GetExtra(first, count), child);
+  };
+  switch (node.kind) {
+    case Kind::Empty:
+      return true;
+    case Kind::Inversion:
+    case Kind::IsVoid:
+    case Kind::Not:
+      return child(node.lhs);
+    case Kind::Plus:
+    case Kind::Mul:
+    case Kind::Div:
+    case Kind::Sub:
+    case Kind::Less:
+    case Kind::LessEq:
+    case Kind::Equal:
+    case Kind::While:
+      return child(node.lhs) && child(node.rhs);
+    case Kind::Int:
+      return node.lhs < _ints.size();
+    case Kind::String:
+    case Kind::Id:
+    case Kind::New:
+      return symbol(node.lhs);
+    case Kind::Bool:
+      return node.lhs <= 1;
+    case Kind::Assign:
+      return symbol(node.lhs) && child(node.rhs);
+    case Kind::If:
+      return children(node.lhs, 3);
+    case Kind::Block:
+      return children(node.lhs, node.rhs);
+    case Kind::Dispatch: {
+      if (!extra(node.lhs, 5)) {
+        return false;
+      }
+      auto operands = GetExtra(node.lhs, 5);
+      return child(operands[0]) && (operands[1] == kNone || symbol(operands[1])) && symbol(operands[2]) &&
+             children(node.lhs + 5, operands[4]);
+    }
+    case Kind::Let:
+    case Kind::Case: {
+      if (!extra(node.lhs, 2) || !child(_extra[node.lhs])) {
+        return false;
+      }
+      auto count = std::size_t{_extra[node.lhs + 1]};
+      if (!extra(node.lhs + 2, 4 * count)) {
+        return false;
+      }
+      auto bindings = GetExtra(node.lhs + 2, 4 * count);
+      for (std::size_t i = 0; i < bindings.size(); i += 4) {
+        if (!symbol(bindings[i + 1]) || !symbol(bindings[i + 2]) || !child(bindings[i + 3])) {
+          return false;
+        }
+      }
+      return true;
+    }
+  }
+  // unknown kind
+  return false;
+}
+
+std::size_t FlatAst::MemoryUsage() const {
+  return _nodes.capacity() * sizeof(Node) + _types.capacity() * sizeof(Symbol) +
+               _symbols.capacity() * sizeof(Symbol) + _ints.capacity() * sizeof(std::int32_t) +
+               _extra.capacity() * sizeof(Index) + _classes.capacity() * sizeof(Class) +
+               _features.capacity() * sizeof(Feature) + _formals.capacity() * sizeof(Formal);
+}
+
+FlatAst::Index FlatAst::Push(Kind kind, std::size_t line, Index lhs, Index rhs) {
+  assert(_nodes.size() < kNone && "too many nodes");
+  _nodes.push_back({.kind = kind, .line = static_cast<std::uint32_t>(line), .lhs = lhs, .rhs = rhs});
+  _types.push_back(symbols::kNoType);
+  return static_cast<Index>(_nodes.size() - 1);
+}
+
+FlatAst::Index FlatAst::PushSymbol(Symbol symbol) {
+  _symbols.push_back(symbol);
+  return static_cast<Index>(_symbols.size() - 1);
+}
+
+FlatAst::Index FlatAst::PushExtra(std::initializer_list<Index> values) {
+  auto first = static_cast<Index>(_extra.size());
+  _extra.insert(_extra.end(), values.begin(), values.end());
+  return first;
+}
+
+}  // namespace coolc
@@ -0,0 +1,182 @@
+#pragma once
+
+#include "ast/expression.hpp"
+#include "symbol/symbol.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace coolc {
+
+/// Data oriented form of a program: all expressions are 16 byte nodes in one vector, children are 32-bit indices.
+/// Nodes are stored in post-order, so children always precede their parent and a bottom-up pass is a linear scan.
+/// Symbols, integer literals and variable length operands live in side arrays. The types inferred by Semant are
+/// kept in a separate array parallel to the nodes.
+///
+/// Operands of the nodes by kind:
+///   Inversion, IsVoid, Not      lhs = argument
+///   Plus ... Equal              lhs, rhs = operands
+///   Int                         lhs = index in the integers
+///   String, Id, New             lhs = index in the symbols
+///   Bool                        lhs = value
+///   Assign                      lhs = index in the symbols, rhs = value
+///   While                       lhs = condition, rhs = body
+///   If                          lhs = extra: condition, then, else
+///   Block                       lhs = extra: expressions, rhs = number of the expressions
+///   Dispatch                    lhs = extra: object, static type symbol or kNone, method symbol, method line,
+///                               number of the arguments, arguments
+///   Let, Case                   lhs = extra: body (Let) or scrutinee (Case), number of the bindings,
+///                               then line, name symbol, type symbol, initializer or branch per binding
+class FlatAst {
+ public:
+  using Index = std::uint32_t;
+
+  static constexpr Index kNone = std::numeric_limits<Index>::max();
+
+  enum class Kind : std::uint8_t {
+    Empty,
+    Inversion,
+    IsVoid,
+    Not,
+    Plus,
+    Mul,
+    Div,
+    Sub,
+    Less,
+    LessEq,
+    Equal,
+    Int,
+    String,
+    Bool,
+    Id,
+    New,
+    Dispatch,
+    Assign,
+    If,
+    While,
+    Case,
+    Let,
+    Block,
+  };
+
+  struct Node {
+    Kind kind{Kind::Empty};
+    std::uint32_t line{0};
+    Index lhs{kNone};
+    Index rhs{kNone};
+  };
+
+  /// Method if body is an expression of a method, formals are [first_formal, first_formal + formal_count)
+  struct Feature {
+    bool is_method{false};
+    std::uint32_t line{0};
+    Symbol object_id;
+    Symbol type_id;
+    Index first_formal{0};
+    Index formal_count{0};
+    Index body{kNone};
+  };
+
+  /// features are [first_feature, first_feature + feature_count)
+  struct Class {
+    std::uint32_t line{0};
+    Symbol type;
+    Symbol inherits_type;
+    std::string filename;
+    Index first_feature{0};
+    Index feature_count{0};
+  };
+
+  static FlatAst FromProgram(const Program& program);
+
+  /// Tree form of the program with the same printed form, expressions are allocated in a new arena
+  Program ToProgram() const;
+
+  /// Version of the binary image, bumped whenever the layout of the image or of the nodes changes
+  static constexpr std::uint32_t kImageVersion = 1;
+
+  /// Binary image of the tree: a header with the version and source_hash, then every array as it is laid out in
+  /// memory, with zeros in the padding of the nodes. Symbols are written as indices into a string table of the image,
+  /// so loading interns only the distinct strings.
+  std::string Serialize(std::uint64_t source_hash) const;
+
+  /// Tree of an image made by Serialize, nullopt if the image is truncated, malformed, of another version or byte
+  /// order, or was made for another source. The arrays are copied out of the image, which needs no alignment, and the
+  /// symbol indices are mapped to symbols. Every node is checked: its kind is known, its children precede it and its
+  /// indices into the side arrays are in bounds.
+  static std::optional<FlatAst> Deserialize(std::string_view image, std::uint64_t source_hash);
+
+  std::span<const Node> Nodes() const {
+    return _nodes;
+  }
+  const Node& operator[](Index index) const {
+    return _nodes[index];
+  }
+  Symbol Type(Index index) const {
+    return _types[index];
+  }
+  void SetType(Index index, Symbol type) {
+    _types[index] = type;
+  }
+
+  std::span<const Class> Classes() const {
+    return _classes;
+  }
+  std::span<const Feature> Features(const Class& cl) const {
+    return std::span{_features}.subspan(cl.first_feature, cl.feature_count);
+  }
+  std::span<const Formal> Formals(const Feature& feature) const {
+    return std::span{_formals}.subspan(feature.first_formal, feature.formal_count);
+  }
+
+  Symbol GetSymbol(Index index) const {
+    return _symbols[index];
+  }
+  std::int32_t GetInt(Index index) const {
+    return _ints[index];
+  }
+  std::span<const Index> GetExtra(Index first, std::size_t count) const {
+    return std::span{_extra}.subspan(first, count);
+  }
+
+  std::uint32_t ProgramLine() const {
+    return _line;
+  }
+
+  /// Heap memory owned by the tree in bytes, file names are not counted
+  std::size_t MemoryUsage() const;
+
+ private:
+  class Builder;
+
+  Index Push(Kind kind, std::size_t line, Index lhs = kNone, Index rhs = kNone);
+  Index PushSymbol(Symbol symbol);
+  Index PushExtra(std::initializer_list<Index> values);
+
+  /// whether the operands of a deserialized node are in bounds and its children precede it
+  bool IsValid(Index index) const;
+
+  /// tree form of the node, the expressions of its children are taken from expanded
+  Expression* Expand(Index index, std::span<Expression* const> expanded, util::Arena* arena) const;
+
+  std::uint32_t _line{0};
+  std::vector<Node> _nodes;
+  std::vector<Symbol> _types;
+  std::vector<Symbol> _symbols;
+  std::vector<std::int32_t> _ints;
+  std::vector<Index> _extra;
+  std::vector<Class> _classes;
+  std::vector<Feature> _features;
+  std::vector<Formal> _formals;
+};
+
+static_assert(sizeof(FlatAst::Node) == 16);
+
+}  // namespace coolc
@@ -1,4 +1,5 @@
 #include "ast/expression.hpp"
+#include "token/string_literal.hpp"
 
 #include <iostream>
 #include <variant>
@@ -102,7 +103,9 @@ void PrintExpression(const Expression& expression, int offset) {
       },
       [offset](const UnaryExpressionT auto& expr) { PrintExpression(*expr.arg, offset); },
       [&offset_str](const Int& expr) { std::cout << offset_str << expr.value << std::endl; },
-      [&offset_str](const String& expr) { std::cout << offset_str << '"' << expr.value << '"' << std::endl; },
+      [&offset_str](const String& expr) {
+        std::cout << offset_str << '"' << EscapeStringLiteral(expr.value.View()) << '"' << std::endl;
+      },
       [&offset_str](const Bool& expr) { std::cout << offset_str << expr.value << std::endl; },
       [&offset_str](const Id& expr) { std::cout << offset_str << expr.name << std::endl; },
       [&offset_str](const New& expr) { std::cout << offset_str << expr.type << std::endl; },
@@ -0,0 +1,304 @@
+#include "gen/program_generator.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace coolc::gen {
+
+namespace {
+
+constexpr std::string_view kTypeNames[] = {"Int", "String", "Bool"};
+
+/// index of the weight chosen with probability proportional to it, value must be in [0, sum of weights)
+std::size_t Pick(std::initializer_list<unsigned> weights, std::size_t value) {
+  std::size_t index = 0;
+  for (auto weight : weights) {
+    if (value < weight) {
+      return index;
+    }
+    value -= weight;
+    ++index;
+  }
+  return index - 1;
+}
+
+}  // namespace
+
+ProgramGenerator::ProgramGenerator(Options options) : _options{std::move(options)}, _random{_options.seed} {
+}
+
+std::size_t ProgramGenerator::Generate(std::ostream& os) {
+  std::size_t bytes = 0;
+  std::string text;
+  for (std::size_t i = 0; i < _options.classes || bytes < _options.min_bytes; ++i) {
+    text.clear();
+    GenerateClass(i, &text);
+    os << text;
+    bytes += text.size();
+  }
+  text.clear();
+  GenerateMain(&text);
+  os << text;
+  return bytes + text.size();
+}
+
+void ProgramGenerator::GenerateClass(std::size_t index, std::string* out) {
+  auto parent = kNoParent;
+  std::size_t depth = 0;
+  if (index > 0 && _options.fanout > 0) {
+    auto candidate = (index - 1) / _options.fanout;
+    if (_depths[candidate] < _options.inheritance_depth) {
+      parent = candidate;
+      depth = _depths[candidate] + 1;
+    }
+  }
+  _parents.push_back(parent);
+  _depths.push_back(depth);
+  _class = index;
+
+  auto name = std::to_string(index);
+  *out += "class C" + name;
+  if (parent != kNoParent) {
+    *out += " inherits C" + std::to_string(parent);
+  }
+  *out += " {\n";
+
+  // all attributes of the class and its ancestors are in scope of every initializer and method
+  _scope.clear();
+  for (auto cl : Chain(index)) {
+    for (std::size_t k = 0; k < _options.attributes; ++k) {
+      std::string attribute{"c"};
+      attribute += std::to_string(cl) + "_a" + std::to_string(k);
+      _scope.push_back({std::move(attribute), k % 2 == 0 ? Type::Int : Type::String});
+    }
+  }
+  if (_options.error_every > 0 && (index + 1) % _options.error_every == 0) {
+    InjectError(index, out);
+  }
+  for (std::size_t k = 0; k < _options.attributes; ++k) {
+    auto type = k % 2 == 0 ? Type::Int : Type::String;
+    *out += "  c" + name + "_a" + std::to_string(k) + " : " + std::string{kTypeNames[static_cast<int>(type)]} +
+            " <- " + Expr(type, std::min<std::size_t>(_options.expression_depth, 2)) + ";\n";
+  }
+  _scope.push_back({"x", Type::Int});
+  _scope.push_back({"s", Type::String});
+  for (std::size_t j = 0; j < _options.methods; ++j) {
+    auto type = static_cast<Type>(j % 3);
+    *out += "  c" + name + "_m" + std::to_string(j) + "(x : Int, s : String) : " +
+            std::string{kTypeNames[static_cast<int>(type)]} + " {\n    " + Expr(type, _options.expression_depth) +
+            "\n  };\n";
+  }
+  *out += "};\n\n";
+}
+
+void ProgramGenerator::GenerateMain(std::string* out) {
+  *out += "class Main inherits IO {\n  main() : Object {{\n";
+  if (_options.methods > 0 && !_parents.empty()) {
+    *out += "    out_int((new C0).c0_m0(1, \"main\"));\n";
+  }
+  *out += "    out_string(\"\\n\");\n  }};\n};\n";
+}
+
+void ProgramGenerator::InjectError(std::size_t index, std::string* out) {
+  auto kind = _options.errors;
+  if (kind == ErrorKind::Mixed) {
+    kind = Uniform(2) == 0 ? ErrorKind::Syntax : ErrorKind::Semantic;
+  }
+  auto prefix = "  c" + std::to_string(index) + "_bad";
+  if (kind == ErrorKind::Syntax) {
+    switch (Uniform(3)) {
+      case 0:  // no semicolon after the attribute
+        *out += prefix + " : Int <- 1\n";
+        break;
+      case 1:
+        *out += prefix + "() : Int { ) };\n";
+        break;
+      default:
+        *out += prefix + "(x : Int : Int { x };\n";
+        break;
+    }
+    return;
+  }
+  switch (Uniform(4)) {
+    case 0:
+      *out += prefix + " : Int <- \"wrong type\";\n";
+      break;
+    case 1:
+      *out += prefix + "() : Int { undefined_" + std::to_string(index) + " + 1 };\n";
+      break;
+    case 2:
+      *out += prefix + "() : Int { self.no_such_method_" + std::to_string(index) + "() };\n";
+      break;
+    default:
+      *out += prefix + "() : Missing" + std::to_string(index) + " { new Missing" + std::to_string(index) + " };\n";
+      break;
+  }
+}
+
+std::string ProgramGenerator::Expr(Type type, std::size_t depth) {
+  if (depth == 0) {
+    return Leaf(type);
+  }
+  const auto& o = _options;
+  auto choice = Pick({4, 1, 1, o.dispatch_weight, o.let_weight, o.case_weight, o.string_weight},
+                     Uniform(6 + std::size_t{o.dispatch_weight} + o.let_weight + o.case_weight + o.string_weight));
+  switch (choice) {
+    case 0:  // operators of the type
+      switch (type) {
+        case Type::Int: {
+          static constexpr std::string_view kOperators[] = {" + ", " - ", " * "};
+          if (Uniform(8) == 0) {
+            return "~(" + Expr(Type::Int, depth - 1) + ")";
+          }
+          return "(" + Expr(Type::Int, depth - 1) + std::string{kOperators[Uniform(3)]} + Expr(Type::Int, depth - 1) +
+                 ")";
+        }
+        case Type::String:
+          if (Uniform(2) == 0) {
+            return "(" + Expr(Type::String, depth - 1) + ").concat(" + Expr(Type::String, depth - 1) + ")";
+          }
+          return "(" + Expr(Type::String, depth - 1) + ").substr(0, " + Expr(Type::Int, depth - 1) + ")";
+        case Type::Bool: {
+          static constexpr std::string_view kComparisons[] = {" < ", " <= ", " = "};
+          switch (Uniform(4)) {
+            case 0:
+              return "not (" + Expr(Type::Bool, depth - 1) + ")";
+            case 1:
+              return "isvoid (" + Expr(AnyType(), depth - 1) + ")";
+            default:
+              return "(" + Expr(Type::Int, depth - 1) + std::string{kComparisons[Uniform(3)]} +
+                     Expr(Type::Int, depth - 1) + ")";
+          }
+        }
+      }
+      break;
+    case 1:
+      return "if " + Expr(Type::Bool, depth - 1) + " then " + Expr(type, depth - 1) + " else " +
+             Expr(type, depth - 1) + " fi";
+    case 2: {
+      auto first = Uniform(2) == 0 ? Expr(AnyType(), depth - 1)
+                                   : "while " + Expr(Type::Bool, depth - 1) + " loop " + Expr(AnyType(), depth - 1) +
+                                         " pool";
+      return "{ " + first + "; " + Expr(type, depth - 1) + "; }";
+    }
+    case 3:
+      return Dispatch(type, depth);
+    case 4:
+      return Let(type, depth);
+    case 5:
+      return Case(type, depth);
+    default:  // string literals and the methods of String
+      switch (type) {
+        case Type::Int:
+          return "(" + Expr(Type::String, depth - 1) + ").length()";
+        case Type::String:
+          return Uniform(2) == 0 ? "\"lorem ipsum " + std::to_string(Uniform(1000)) + "\\t\"" : "type_name()";
+        case Type::Bool:
+          return "(" + Expr(Type::String, depth - 1) + " = " + Expr(Type::String, depth - 1) + ")";
+      }
+  }
+  return Leaf(type);
+}
+
+std::string ProgramGenerator::Leaf(Type type) {
+  if (Uniform(2) == 0) {
+    std::vector<const Variable*> candidates;
+    for (const auto& variable : _scope) {
+      if (variable.type == type) {
+        candidates.push_back(&variable);
+      }
+    }
+    if (!candidates.empty()) {
+      return candidates[Uniform(candidates.size())]->name;
+    }
+  }
+  switch (type) {
+    case Type::Int:
+      return std::to_string(Uniform(1000));
+    case Type::String:
+      return "\"s" + std::to_string(Uniform(1000)) + "\"";
+    case Type::Bool:
+      return Uniform(2) == 0 ? "true" : "false";
+  }
+  return {};
+}
+
+std::string ProgramGenerator::Dispatch(Type type, std::size_t depth) {
+  // methods of a class returning the type are j = type, type + 3, ...
+  auto first = static_cast<std::size_t>(type);
+  if (first >= _options.methods) {
+    return Leaf(type);
+  }
+  auto method = first + 3 * Uniform((_options.methods - first + 2) / 3);
+  std::string arguments{"("};
+  arguments += Expr(Type::Int, depth - 1) + ", " + Expr(Type::String, depth - 1) + ")";
+  auto call = [&](std::size_t cl) {
+    std::string text{"c"};
+    text += std::to_string(cl) + "_m" + std::to_string(method) + arguments;
+    return text;
+  };
+
+  auto own_chain = Chain(_class);
+  switch (Uniform(4)) {
+    case 0:
+      return call(own_chain[Uniform(own_chain.size())]);
+    case 1: {
+      auto cl = own_chain[Uniform(own_chain.size())];
+      return "self@C" + std::to_string(cl) + "." + call(cl);
+    }
+    case 2: {
+      auto cl = Uniform(_class + 1);
+      return "(new C" + std::to_string(cl) + ")." + call(cl);
+    }
+    default: {
+      auto receiver = Uniform(_class + 1);
+      auto chain = Chain(receiver);
+      auto cl = chain[Uniform(chain.size())];
+      return "(new C" + std::to_string(receiver) + ")@C" + std::to_string(cl) + "." + call(cl);
+    }
+  }
+}
+
+std::string ProgramGenerator::Let(Type type, std::size_t depth) {
+  auto variable_type = AnyType();
+  auto name = FreshName();
+  auto text = "(let " + name + " : " + std::string{kTypeNames[static_cast<int>(variable_type)]} + " <- " +
+              Expr(variable_type, depth - 1) + " in ";
+  _scope.push_back({name, variable_type});
+  text += Expr(type, depth - 1) + ")";
+  _scope.pop_back();
+  return text;
+}
+
+std::string ProgramGenerator::Case(Type type, std::size_t depth) {
+  auto text = "case " + Expr(AnyType(), depth - 1) + " of ";
+  for (auto branch : {Type::Int, Type::String}) {
+    auto name = FreshName();
+    _scope.push_back({name, branch});
+    text += name + " : " + std::string{kTypeNames[static_cast<int>(branch)]} + " => " + Expr(type, depth - 1) + "; ";
+    _scope.pop_back();
+  }
+  return text + FreshName() + " : Object => " + Expr(type, depth - 1) + "; esac";
+}
+
+std::vector<std::size_t> ProgramGenerator::Chain(std::size_t index) const {
+  std::vector<std::size_t> chain;
+  for (auto cl = index; cl != kNoParent; cl = _parents[cl]) {
+    chain.push_back(cl);
+  }
+  return chain;
+}
+
+std::string ProgramGenerator::FreshName() {
+  std::string name{"v"};
+  name += std::to_string(_names++);
+  return name;
+}
+
+}  // namespace coolc::gen
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace coolc::gen {
+
+enum class ErrorKind { Syntax, Semantic, Mixed };
+
+struct Options {
+  std::uint64_t seed{1};
+  /// at least this many classes are generated, more if min_bytes is not reached yet
+  std::size_t classes{16};
+  std::size_t min_bytes{0};
+  /// a class inherits class (index - 1) / fanout unless that would make the chain deeper, then it is a root
+  std::size_t inheritance_depth{4};
+  std::size_t fanout{3};
+  std::size_t methods{6};
+  std::size_t attributes{2};
+  std::size_t expression_depth{4};
+  /// relative weights of compound expressions, arithmetic, conditionals and blocks have fixed weights 4, 1 and 1
+  unsigned dispatch_weight{4};
+  unsigned let_weight{2};
+  unsigned case_weight{1};
+  unsigned string_weight{2};
+  /// every error_every-th class gets one deliberate error of the kind, zero gives a correct program
+  std::size_t error_every{0};
+  ErrorKind errors{ErrorKind::Mixed};
+};
+
+/// Writes random Cool programs which pass the parser and Semant unless errors are requested.
+/// Classes C<i> have attributes c<i>_a<k> of Int and String types and methods c<i>_m<j>(x : Int, s : String)
+/// returning Int, String or Bool by j % 3; names are unique, so no feature is redefined. Expressions are generated
+/// for the type they need, dispatches go to self, to the ancestors through static dispatch and to new objects of the
+/// classes written before. The program is written class by class, so memory does not grow with its size, and only
+/// raw output of std::mt19937_64 is used, so the same options give the same bytes everywhere.
+class ProgramGenerator {
+ public:
+  explicit ProgramGenerator(Options options);
+
+  /// Writes the whole program to os, returns the number of bytes written
+  std::size_t Generate(std::ostream& os);
+
+ private:
+  enum class Type : std::uint8_t { Int, String, Bool };
+
+  struct Variable {
+    std::string name;
+    Type type;
+  };
+
+  static constexpr std::size_t kNoParent = static_cast<std::size_t>(-1);
+
+  void GenerateClass(std::size_t index, std::string* out);
+  void GenerateMain(std::string* out);
+  void InjectError(std::size_t index, std::string* out);
+
+  std::string Expr(Type type, std::size_t depth);
+  std::string Leaf(Type type);
+  std::string Dispatch(Type type, std::size_t depth);
+  std::string Let(Type type, std::size_t depth);
+  std::string Case(Type type, std::size_t depth);
+
+  /// the class and its ancestors up to a root
+  std::vector<std::size_t> Chain(std::size_t index) const;
+  std::string FreshName();
+
+  std::size_t Uniform(std::size_t n) {
+    return n == 0 ? 0 : static_cast<std::size_t>(_random() % n);
+  }
+  Type AnyType() {
+    return static_cast<Type>(Uniform(3));
+  }
+
+  Options _options;
+  std::mt19937_64 _random;
+  std::vector<std::size_t> _parents;
+  std::vector<std::size_t> _depths;
+  std::vector<Variable> _scope;
+  std::size_t _class{0};
+  std::size_t _names{0};
+};
+
+}  // namespace coolc::gen
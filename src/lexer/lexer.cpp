@@ -1,331 +1,493 @@
 #include "lexer/lexer.hpp"
 
+#include "lexer/scan.hpp"
+#include "token/string_literal.hpp"
 #include "token/token.hpp"
+#include "token/token_buffer.hpp"
+#include "token/token_stream.hpp"
+#include "util/thread_pool.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <cctype>
+#include <cerrno>
 #include <cstdint>
 #include <cstring>
-#include <limits>
 #include <optional>
-#include <regex>
-#include <sstream>
+#include <ranges>
 #include <string>
+#include <string_view>
+#include <system_error>
 #include <vector>
 
+#include <unistd.h>
+
 namespace coolc {
 
 namespace {
 
-// just private helper to skip characters after null character in string
-void SkipAfterNull(std::stringstream* ss) {
-  while (!ss->eof() && ss->peek() != '\n' && ss->peek() != '"') {
-    ss->get();
-  }
-  if (ss->peek() == '"') {
-    ss->get();
-  }
-}
-
 // pre-condition: lexeme.size() > 0
 bool IsTypeId(std::string_view lexeme) {
-  return std::isupper(lexeme[0]);
+  return std::isupper(static_cast<unsigned char>(lexeme[0]));
+}
+
+/// tokens whose lexeme is their text in the source
+bool HasTextLexeme(Token::Type type) {
+  return type == Token::Type::TypeID || type == Token::Type::ObjectID || type == Token::Type::Integer;
+}
+
+/// 0 only at the end of input
+std::size_t ReadSome(int fd, char* data, std::size_t size) {
+  while (true) {
+    auto read = ::read(fd, data, size);
+    if (read >= 0) {
+      return static_cast<std::size_t>(read);
+    }
+    if (errno != EINTR) {
+      throw std::system_error{errno, std::generic_category(), "read"};
+    }
+  }
 }
 
 }  // namespace
 
-Lexer::Lexer(std::string source_code) : _current_line{1}, _sstream{std::move(source_code)} {
+Lexer::Lexer(std::string source_code)
+    : _current_line{1},
+      _storage{std::make_shared<const std::string>(std::move(source_code))},
+      _source{*_storage},
+      _pos{0},
+      _scan{&scan::Dispatch()} {
+}
+
+Lexer::Lexer(std::string_view source_code)
+    : _current_line{1}, _source{source_code}, _pos{0}, _scan{&scan::Dispatch()} {
+}
+
+Lexer::Lexer(const char* source_code) : Lexer(std::string_view{source_code}) {
+}
+
+Lexer::Lexer(int fd, std::size_t chunk_size)
+    : _current_line{1}, _pos{0}, _scan{&scan::Dispatch()}, _fd{fd}, _chunk_size{chunk_size}, _input_eof{false} {
+}
+
+Lexer Lexer::FromFileDescriptor(int fd, std::size_t chunk_size) {
+  return Lexer{fd, std::max<std::size_t>(chunk_size, 1)};
 }
 
 Token Lexer::NextToken() {
-  SkipWs();
-  if (!_sstream.good()) {
-    return {};
+  Token token{.type = _input_eof ? Scan() : ScanStream()};
+  token.lexeme = Lexeme(token.type);
+  token.line = _current_line;
+  return token;
+}
+
+TokenBuffer Lexer::Tokenize() {
+  ReadRest();
+  TokenBuffer tokens{_source, _storage, FirstLine()};
+  for (auto type = Scan(); type != Token::Type::Unknown || _has_value; type = Scan()) {
+    PushToken(&tokens, type);
+    assert(tokens.Line(tokens.size() - 1) == _current_line);
   }
-  if (auto token = GetSpecial(); token) {
-    return *token;
+  tokens.Finish(_current_line);
+  return tokens;
+}
+
+struct Lexer::Chunk {
+  std::size_t end{0};
+  TokenBuffer tokens{};
+  /// positions where scans of the tokens have started, the scan of the first token starts at the chunk begin
+  std::vector<std::uint32_t> scan_starts{};
+  /// position where the scan after the last token starts
+  std::size_t last{0};
+};
+
+Lexer::Chunk Lexer::LexChunk(std::string_view source, std::size_t begin, std::size_t end) {
+  Chunk chunk{.end = end};
+  Lexer lexer(source);
+  lexer._pos = begin;
+  while (lexer._pos < end) {
+    auto start = lexer._pos;
+    auto type = lexer.Scan();
+    if (type == Token::Type::Unknown && !lexer._has_value) {
+      break;
+    }
+    chunk.scan_starts.push_back(static_cast<std::uint32_t>(start));
+    lexer.PushToken(&chunk.tokens, type);
   }
-  if (auto token = GetIntLiteral(); token) {
-    return *token;
+  chunk.last = lexer._pos;
+  return chunk;
+}
+
+TokenBuffer Lexer::Tokenize(util::ThreadPool& pool, std::size_t min_chunk_size) {
+  ReadRest();
+  auto count = std::clamp<std::size_t>((_source.size() - _pos) / std::max<std::size_t>(min_chunk_size, 1), 1,
+                                       pool.Size());
+  if (count == 1) {
+    return Tokenize();
   }
-  if (auto token = GetStringLiteral(); token) {
-    return *token;  // may be error
+  auto first_line = FirstLine();
+  // chunks start after a newline, where the speculative state is likely to be right
+  std::vector<std::size_t> bounds{_pos};
+  for (std::size_t i = 1; i < count; ++i) {
+    auto split = _pos + (_source.size() - _pos) * i / count;
+    auto newline = _source.find('\n', std::max(split, bounds.back()));
+    bounds.push_back(newline == std::string_view::npos ? _source.size() : newline + 1);
   }
-  std::string lexeme;
-  _sstream >> lexeme;
-  assert(!lexeme.empty());
-  if (auto token = GetKeyword(lexeme); token) {
-    return *token;
+  bounds.push_back(_source.size());
+
+  std::vector<std::future<Chunk>> chunks;
+  for (std::size_t i = 0; i + 1 < bounds.size(); ++i) {
+    chunks.push_back(pool.Submit([source = _source, begin = bounds[i], end = bounds[i + 1]] {
+      return LexChunk(source, begin, end);
+    }));
   }
 
-  // ObjectID / TypeID
-  if (!std::isalpha(lexeme[0])) {
-    return Token{.lexeme = "Unknown error", .line = _current_line};
-  }
-  std::regex rgx;
-  Token::Type token_type{};
-  if (IsTypeId(lexeme)) {
-    rgx = R"(^[A-Z]\w*)";
-    token_type = Token::Type::TypeID;
-  } else {
-    rgx = R"(^[a-z]\w*)";
-    token_type = Token::Type::ObjectID;
-  }
-  std::smatch match;
-  std::regex_search(lexeme, match, rgx);
-  lexeme = match[0];
-  _sstream.seekg(-match.suffix().length(), std::ios_base::cur);
-  return MakeToken(token_type, lexeme);
-}
+  TokenBuffer tokens{_source, _storage, first_line};
+  Lexer relexer(_source);
+  std::size_t pos = _pos;
+  for (auto& future : chunks) {
+    auto chunk = future.get();
+    while (pos < chunk.end) {
+      auto start = std::lower_bound(chunk.scan_starts.begin(), chunk.scan_starts.end(), pos);
+      if (start != chunk.scan_starts.end() && *start == pos) {
+        tokens.Append(chunk.tokens, start - chunk.scan_starts.begin());
+        pos = chunk.last;
+        break;
+      }
+      relexer._pos = pos;
+      auto type = relexer.Scan();
+      pos = relexer._pos;
+      if (type == Token::Type::Unknown && !relexer._has_value) {
+        break;
+      }
+      relexer.PushToken(&tokens, type);
+    }
+  }
 
-std::vector<Token> Lexer::Tokenize() {
-  auto is_eof = [](const Token& token) { return !token.lexeme && token.type == Token::Type::Unknown; };
-  std::vector<Token> result;
-  for (auto token = NextToken(); !is_eof(token); token = NextToken()) {
-    result.push_back(std::move(token));
+  // the line of the end of file is counted by the scan after the last token: a line comment there adds a line
+  if (!tokens.empty()) {
+    _pos = tokens.End(tokens.size() - 1);
+    _current_line = tokens.Line(tokens.size() - 1);
   }
-  result.push_back(MakeToken(Token::Type::Unknown));
-  return result;
+  [[maybe_unused]] auto type = Scan();
+  assert(type == Token::Type::Unknown && !_has_value);
+  tokens.Finish(_current_line);
+  return tokens;
 }
 
-void Lexer::SkipWs() {
-  while (_sstream.good() && std::isspace(_sstream.peek())) {
-    if (_sstream.get() == '\n') {
-      _current_line++;
+TokenBuffer::Change Lexer::Relex(TokenBuffer* tokens, std::string_view source, const Edit& edit) {
+  assert(source.substr(edit.offset, edit.inserted.size()) == edit.inserted);
+  auto count = tokens->size() - 1;  // without the end of file
+  // a scan reads one character after the end of its token, so a token which ends at the offset is damaged too
+  auto indices = std::views::iota(std::size_t{0}, count);
+  auto first = static_cast<std::size_t>(
+      std::ranges::partition_point(indices, [&](std::size_t index) { return tokens->End(index) < edit.offset; }) -
+      indices.begin());
+  // position where the scan of the i-th token has started in the old source
+  auto scan_start = [tokens](std::size_t index) { return index == 0 ? 0 : tokens->End(index - 1); };
+
+  Lexer lexer(source);
+  lexer._pos = scan_start(first);
+  lexer._current_line = first == 0 ? 1 : tokens->Line(first - 1);
+  auto inserted_end = edit.offset + edit.inserted.size();
+  TokenBuffer replacement;
+  std::size_t last = first;
+  while (true) {
+    if (lexer._pos >= inserted_end) {
+      // the rest of the source is the same, so the scans from the same positions are the same
+      auto old_pos = lexer._pos - edit.inserted.size() + edit.removed;
+      while (last <= count && scan_start(last) < old_pos) {
+        ++last;
+      }
+      if (last <= count && scan_start(last) == old_pos) {
+        tokens->Splice(source, edit.offset, edit.removed, first, last, replacement, {});
+        return {.first = first, .removed = last - first, .inserted = replacement.size()};
+      }
     }
+    auto type = lexer.Scan();
+    if (type == Token::Type::Unknown && !lexer._has_value) {
+      break;
+    }
+    lexer.PushToken(&replacement, type);
   }
+  tokens->Splice(source, edit.offset, edit.removed, first, count, replacement, lexer._current_line);
+  return {.first = first, .removed = count - first, .inserted = replacement.size()};
 }
 
-/// pre-condition: string_stream is inside multiline comment
-/// skip comment and get next token or return error
-Token Lexer::SkipComment() {
-  std::regex reg(R"((\(\*|\*\)))");
-  std::cmatch match;
-  int32_t comment_counter = 1;
-  // TODO: why str is incorrect here ?
-  // TODO: stupid compiler/STL in CI, change this code latter
-  auto tmp_sstream = _sstream.str();
-  auto tmp_sstream_offset = _sstream.tellg();
-  while (std::regex_search(tmp_sstream.c_str() + tmp_sstream_offset, match, reg)) {
-    auto prefix = match.prefix().str();
-    long offset = prefix.size() + match[0].length();
-    _current_line += std::count(prefix.begin(), prefix.end(), '\n');
-    _sstream.seekg(_sstream.tellg() + offset);
-    tmp_sstream_offset = _sstream.tellg();
-    comment_counter += match[0].str() == "*)" ? -1 : 1;
-    if (comment_counter == 0) {
-      return NextToken();
-    }
+void Lexer::ReadRest() {
+  if (_fd < 0) {
+    return;
   }
-  for (auto el = tmp_sstream.c_str() + _sstream.tellg(); *el != '\0'; ++el) {
-    if (*el == '\n') {
-      _current_line++;
+  while (!_input_eof) {
+    Refill();
+  }
+  _storage = std::make_shared<const std::string>(std::move(_window));
+  _source = *_storage;
+  _fd = -1;
+}
+
+std::uint32_t Lexer::FirstLine() const {
+  return _current_line - static_cast<std::uint32_t>(std::count(_source.begin(), _source.begin() + _pos, '\n'));
+}
+
+std::optional<Symbol> Lexer::Lexeme(Token::Type type) const {
+  if (_has_value) {
+    return Symbol::Intern(_value);
+  }
+  if (HasTextLexeme(type)) {
+    return Symbol::Intern(_source.substr(_token_begin, _pos - _token_begin));
+  }
+  if (type == Token::Type::String) {
+    return Symbol::Intern(StringLiteralContent(_source.substr(_token_begin, _pos - _token_begin)));
+  }
+  return {};
+}
+
+void Lexer::PushToken(TokenBuffer* tokens, Token::Type type) const {
+  if (auto lexeme = Lexeme(type); lexeme) {
+    tokens->Push(type, _token_begin, _pos, *lexeme);
+  } else {
+    tokens->Push(type, _token_begin, _pos);
+  }
+}
+
+TokenStream Lexer::Stream() {
+  return TokenStream{[this] { return NextToken(); }};
+}
+
+Token::Type Lexer::ScanStream() {
+  while (true) {
+    auto pos = _pos;
+    auto line = _current_line;
+    auto type = Scan();
+    if (_pos < _source.size() || _input_eof) {
+      return type;
     }
+    _pos = pos;
+    _current_line = line;
+    Refill();
   }
-  _sstream.setstate(std::stringstream::eofbit);
-  return MakeToken(Token::Type::Unknown, "EOF in comment");
 }
 
-std::optional<Token> Lexer::GetSpecial() {
-  char curr = _sstream.get();
+void Lexer::Refill() {
+  _window.erase(0, _pos);
+  _pos = 0;
+  auto size = _window.size();
+  auto to_read = std::max(_chunk_size, size);
+  _window.resize(size + to_read);
+  auto read = ReadSome(_fd, _window.data() + size, to_read);
+  _window.resize(size + read);
+  _input_eof = read == 0;
+  _source = _window;
+}
 
-  if (auto token = CheckInvalid(curr); token) {
-    return *token;
+Token::Type Lexer::Scan() {
+  _has_value = false;
+  while (true) {
+    SkipWs();
+    _token_begin = _pos;
+    if (Eof()) {
+      return Token::Type::Unknown;
+    }
+    if (Peek() == '-' && Peek(1) == '-') {
+      SkipLineComment();
+      continue;
+    }
+    if (Peek() == '(' && Peek(1) == '*') {
+      _pos += 2;
+      if (auto error = SkipComment(); error) {
+        return *error;
+      }
+      continue;
+    }
+    break;
   }
 
-  if (curr == '(') {
-    char next = _sstream.get();
-    switch (next) {
-      case '*':
-        return SkipComment();
-      default:
-        _sstream.putback(next);
-        return MakeToken(Token::Type::LParen);
+  if (auto type = GetSpecial(); type) {
+    return *type;
+  }
+  if (auto type = GetIntLiteral(); type) {
+    return *type;
+  }
+  if (auto type = GetStringLiteral(); type) {
+    return *type;  // may be error
+  }
+
+  // ObjectID / TypeID
+  if (!std::isalpha(Peek())) {
+    // skip the whole whitespace delimited word
+    while (!Eof() && !std::isspace(Peek())) {
+      ++_pos;
     }
+    return MakeError("Unknown error");
   }
-  if (curr == '-') {
-    char next = _sstream.get();
-    switch (next) {
-      case '-':
-        _sstream.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-        _current_line++;
-        return NextToken();
-      default:
-        _sstream.putback(next);
-        return MakeToken(Token::Type::Minus);
+  auto begin = _pos;
+  _pos = _scan->find_word_end(_source.data() + _pos, _source.data() + _source.size()) - _source.data();
+  auto lexeme = _source.substr(begin, _pos - begin);
+  if (auto type = Token::KeywordFromString(lexeme); type != Token::Type::Unknown) {
+    return type;
+  }
+  return IsTypeId(lexeme) ? Token::Type::TypeID : Token::Type::ObjectID;
+}
+
+void Lexer::SkipWs() {
+  auto begin = _source.data();
+  _pos = _scan->skip_whitespace(begin + _pos, begin + _source.size(), &_current_line) - begin;
+}
+
+/// pre-condition: _pos points to the "--"
+void Lexer::SkipLineComment() {
+  auto end = _source.find('\n', _pos);
+  _pos = end == std::string_view::npos ? _source.size() : end + 1;
+  _current_line++;
+}
+
+/// pre-condition: _pos is inside multiline comment
+/// skip comment or return error if it is not closed
+std::optional<Token::Type> Lexer::SkipComment() {
+  auto begin = _source.data();
+  auto end = begin + _source.size();
+  int32_t comment_counter = 1;
+  for (auto curr = _scan->find_comment_delimiter(begin + _pos, end); curr != end;
+       curr = _scan->find_comment_delimiter(curr, end)) {
+    if (*curr == '\n') {
+      _current_line++;
+      ++curr;
+      continue;
+    }
+    comment_counter += *curr == '(' ? 1 : -1;
+    curr += 2;
+    if (comment_counter == 0) {
+      _pos = curr - begin;
+      return {};
     }
   }
-  if (curr == '*') {
-    char next = _sstream.get();
-    switch (next) {
-      case ')':
-        return MakeToken(Token::Type::Unknown, "Unmatched *)");
-      default:
-        _sstream.putback(next);
-        return MakeToken(Token::Type::Mul);
+  _pos = _source.size();
+  return MakeError("EOF in comment");
+}
+
+std::optional<Token::Type> Lexer::GetSpecial() {
+  char curr = _source[_pos];
+
+  if (auto type = CheckInvalid(curr); type) {
+    ++_pos;
+    return *type;
+  }
+
+  auto match_next = [this](char expected) {
+    if (Peek(1) == expected) {
+      _pos += 2;
+      return true;
     }
+    return false;
+  };
+
+  if (curr == '*' && match_next(')')) {
+    return MakeError("Unmatched *)");
   }
   if (curr == '<') {
-    char next = _sstream.get();
-    switch (next) {
-      case '=':
-        return MakeToken(Token::Type::Leq);
-      case '-':
-        return MakeToken(Token::Type::Assign);
-      default:
-        _sstream.putback(next);
-        return MakeToken(Token::Type::Less);
+    if (match_next('=')) {
+      return Token::Type::Leq;
     }
-  }
-  if (curr == '=') {
-    char next = _sstream.get();
-    switch (next) {
-      case '>':
-        return MakeToken(Token::Type::Darrow);
-      default:
-        _sstream.putback(next);
-        return MakeToken(Token::Type::Equals);
+    if (match_next('-')) {
+      return Token::Type::Assign;
     }
   }
+  if (curr == '=' && match_next('>')) {
+    return Token::Type::Darrow;
+  }
 
-  if (auto type = Token::FromString(std::string{curr}); type != Token::Type::Unknown) {
-    return MakeToken(type);
+  if (auto type = Token::PunctuatorFromChar(curr); type != Token::Type::Unknown) {
+    ++_pos;
+    return type;
   }
-  _sstream.putback(curr);
   return {};
 }
 
-std::optional<Token> Lexer::GetIntLiteral() {
-  if (!std::isdigit(_sstream.peek())) {
+std::optional<Token::Type> Lexer::GetIntLiteral() {
+  if (!std::isdigit(Peek())) {
     return {};
   }
-  std::string res;
-  char curr = _sstream.get();
-  while (std::isdigit(curr)) {
-    res.push_back(curr);
-    curr = _sstream.get();
-  }
-  if (_sstream.good()) {
-    _sstream.putback(curr);
+  while (std::isdigit(Peek())) {
+    ++_pos;
   }
-  return MakeToken(Token::Type::Integer, std::move(res));
+  return Token::Type::Integer;
 }
 
-std::optional<Token> Lexer::GetStringLiteral() {
-  static const std::unordered_map<char, const char*> escaped_sequences = {
-      {'\t', "\\t"},  {'\b', "\\b"}, {'\r', "\\015"},   {'\f', "\\f"},     {'\033', "\\033"},
-      {'\\', "\\\\"}, {'\n', "\\n"}, {'\x0b', "\\013"}, {'\x12', "\\022"}, {'\x1B', "\\e"}};
-  static const std::unordered_map<char, const char*> char_to_escape = {
-      {'t', "\\t"}, {'n', "\\n"}, {'b', "\\b"}, {'f', "\\f"}, {'\033', "\\033"}, {'\\', "\\\\"}, {'"', "\\\""}};
+void Lexer::SkipAfterNull() {
+  while (!Eof() && Peek() != '\n' && Peek() != '"') {
+    ++_pos;
+  }
+  if (Peek() == '"') {
+    ++_pos;
+  }
+}
 
-  if (_sstream.peek() != '\"') {
+std::optional<Token::Type> Lexer::GetStringLiteral() {
+  if (Peek() != '\"') {
     return {};
   }
-  std::string buffer{};
-  char c = _sstream.get();
-  size_t buf_len = 0;
-  while (!_sstream.eof()) {
-    char n = _sstream.peek();
+  ++_pos;
+  // the literal is kept as a raw slice of the source, so only its length after escapes is counted here
+  std::size_t length = 0;
+  const char* data = _source.data();
+  while (true) {
+    auto special = _scan->find_string_special(data + _pos, data + _source.size());
+    length += special - (data + _pos);
+    _pos = special - data;
+    if (Eof()) {
+      return MakeError("EOF in string constant");
+    }
+    char n = _source[_pos];
     if (n == '\0') {
-      SkipAfterNull(&_sstream);
-      return MakeToken(Token::Type::Unknown, "String contains null character.");
+      SkipAfterNull();
+      return MakeError("String contains null character.");
     }
     if (n == '\n') {
-      _sstream.get(c);
+      ++_pos;
       _current_line++;
-      return MakeToken(Token::Type::Unknown, "Unterminated string constant");
+      return MakeError("Unterminated string constant");
     }
     if (n == '"') {
-      _sstream.get(c);
-      if (buf_len > 1024) {
-        return MakeToken(Token::Type::Unknown, "String constant too long");
+      ++_pos;
+      if (length > kMaxStringLength) {
+        return MakeError("String constant too long");
       }
-      return MakeToken(Token::Type::String, buffer);
+      return Token::Type::String;
     }
-    if (n == '\\') {
-      _sstream.get(c);
-      char next = _sstream.peek();
-      if (next == '\0') {
-        SkipAfterNull(&_sstream);
-        return MakeToken(Token::Type::Unknown, "String contains escaped null character.");
-      } else if (next == std::char_traits<char>::eof()) {
-        return MakeToken(Token::Type::Unknown, "EOF in string constant");
-      } else if (char_to_escape.contains(next)) {
-        buffer.append(char_to_escape.at(next));
-      } else if (escaped_sequences.contains(next)) {
-        buffer.append(escaped_sequences.at(next));
-        if (next == '\n') {
-          _current_line++;
-        }
-      } else {
-        buffer.push_back(next);
-      }
-      _sstream.get(c);
-    } else if (escaped_sequences.contains(n)) {
-      _sstream.get(c);
-      buffer.append(escaped_sequences.at(c));
-    } else {
-      buffer += _sstream.peek();
-      _sstream.get(c);
+    // backslash
+    ++_pos;
+    if (Eof()) {
+      return MakeError("EOF in string constant");
     }
-    buf_len++;
-  }
-  return MakeToken(Token::Type::Unknown, "EOF in string constant");
-}
-
-std::optional<Token> Lexer::GetKeyword(const std::string& keyword) {
-  std::regex reg(
-      R"(^(class|if|else|fi|inherits|in|isvoid|loop|pool|true|false|while|case|esac|new|of|not|then|let)(\W+.*)*)",
-      std::regex_constants::icase);
-
-  std::smatch match;
-  if (!std::regex_match(keyword, match, reg) || match.prefix().length() > 0) {
-    return {};
-  }
-
-  // TODO: rewrite to std::ranges::views::transform
-  std::string little_str = match[1].str();
-  std::for_each(little_str.begin(), little_str.end(), [](char& el) { el = std::tolower(el); });
-
-  long pos = _sstream.tellg();
-  // TODO: rewrite this code, this is very ugly
-  if (pos == -1) {
-    std::stringstream new_sstr{std::string{keyword.begin() + match[1].length(), keyword.end()}};
-    _sstream.swap(new_sstr);
-  } else {
-    _sstream.seekg(pos - (keyword.size() - match[1].length()));
-  }
-
-  auto token_type = Token::FromString(little_str);
-  if (token_type == Token::Type::Unknown || (token_type == Token::Type::True && !std::islower(keyword[0])) ||
-      (token_type == Token::Type::False && !std::islower(keyword[0]))) {
-    _sstream.seekg(pos);
-    return {};
+    if (_source[_pos] == '\0') {
+      SkipAfterNull();
+      return MakeError("String contains escaped null character.");
+    }
+    if (_source[_pos] == '\n') {
+      _current_line++;
+    }
+    ++_pos;
+    length++;
   }
-  return MakeToken(token_type);
 }
 
-std::optional<Token> Lexer::CheckInvalid(char ch) {
+std::optional<Token::Type> Lexer::CheckInvalid(char ch) {
   if (int i = static_cast<int>(ch); i >= 0 && i <= 4) {
-    return MakeToken(Token::Type::Unknown, "\\00" + std::to_string(i));
+    return MakeError("\\00" + std::to_string(i));
   }
 
   constexpr const char* invalid_characters = "!#$%^&_>?`[]\\|";
   if (std::strchr(invalid_characters, ch)) {
-    std::string to_print{ch};
-    if (ch == '\\') {
-      to_print.push_back('\\');
-    }
-    return MakeToken(Token::Type::Unknown, to_print);
+    return MakeError(ch == '\\' ? std::string_view{"\\\\"} : std::string_view{&ch, 1});
   }
   return {};
 }
 
-Token Lexer::MakeToken(Token::Type type) {
-  return {.type = type, .line = _current_line};
-}
-
-Token Lexer::MakeToken(Token::Type type, std::string lexeme) {
-  return {.type = type, .lexeme = std::move(lexeme), .line = _current_line};
+Token::Type Lexer::MakeError(std::string_view message) {
+  _value.assign(message);
+  _has_value = true;
+  return Token::Type::Unknown;
 }
 
 }  // namespace coolc
@@ -1,38 +1,144 @@
 #pragma once
 
+#include "lexer/scan.hpp"
 #include "token/token.hpp"
+#include "token/token_buffer.hpp"
+#include "token/token_stream.hpp"
+#include "util/thread_pool.hpp"
+
+#include <cstddef>
 
 #include <cstdint>
+#include <memory>
 #include <optional>
-#include <sstream>
 #include <string>
-#include <vector>
+#include <string_view>
 
 namespace coolc {
 
+/// Single forward pass scanner over a contiguous source buffer.
+/// Every character is visited a constant number of times, so Tokenize() is O(n) in the size of the source.
 class Lexer {
  public:
+  /// Owning mode: lexer keeps the source alive
   explicit Lexer(std::string source_code);
 
+  /// Zero-copy mode: source_code must outlive the lexer
+  explicit Lexer(std::string_view source_code);
+  explicit Lexer(const char* source_code);
+
+  static constexpr std::size_t kDefaultChunkSize = std::size_t{1} << 16;
+
+  /// Streaming mode: source is read from fd by chunks of chunk_size bytes when the lexer needs more text.
+  /// Memory is bounded by the chunk size and the longest token or comment. fd is not closed by the lexer.
+  static Lexer FromFileDescriptor(int fd, std::size_t chunk_size = kDefaultChunkSize);
+
+  Lexer(const Lexer&) = delete;
+  Lexer& operator=(const Lexer&) = delete;
+
   Token NextToken();
 
-  std::vector<Token> Tokenize();
+  /// Tokenizes the rest of the source, the buffer keeps the source of an owning lexer alive.
+  /// In the streaming mode the rest of the input is read first.
+  TokenBuffer Tokenize();
+
+  static constexpr std::size_t kMinParallelChunkSize = std::size_t{1} << 16;
+
+  /// Same tokens as Tokenize(), lexed by chunks on the pool.
+  /// Every chunk is lexed speculatively as if it started outside of strings and comments. The chunks are merged in
+  /// order: the real stream is relexed serially from the end of the previous chunk until it reaches a position where
+  /// the speculative lexer of the chunk has started a token scan, the rest of the chunk is taken from there.
+  TokenBuffer Tokenize(util::ThreadPool& pool, std::size_t min_chunk_size = kMinParallelChunkSize);
+
+  /// Change of the source: removed characters starting at offset are replaced with inserted
+  struct Edit {
+    std::size_t offset;
+    std::size_t removed;
+    std::string_view inserted;
+  };
+
+  /// Updates tokens of the whole source to the tokens of source, the text after the edit, and returns the replaced
+  /// tokens, the inserted ones are the scanned tokens. The scan starts at the first token which has read the edited
+  /// text and stops as soon as it starts at a position where the old scan has started too, so the rest of the stream
+  /// is kept. source must outlive tokens.
+  static TokenBuffer::Change Relex(TokenBuffer* tokens, std::string_view source, const Edit& edit);
+
+  /// Tokens are produced on demand, the lexer must outlive the stream
+  TokenStream Stream();
 
  private:
+  struct Chunk;
+
+  Lexer(int fd, std::size_t chunk_size);
+
+  /// tokens which are scanned from [begin, end) of the source without knowing the state at begin
+  static Chunk LexChunk(std::string_view source, std::size_t begin, std::size_t end);
+
+  /// reads the rest of the input of the streaming mode and turns the lexer into the owning mode
+  void ReadRest();
+
+  /// line of the first character of _source, so that the line of _pos is _current_line
+  std::uint32_t FirstLine() const;
+
+  /// lexeme of the current token of Scan(), interned
+  std::optional<Symbol> Lexeme(Token::Type type) const;
+
+  /// pushes the current token of Scan() with its lexeme
+  void PushToken(TokenBuffer* tokens, Token::Type type) const;
+
+  /// Scans the next token, its text is [_token_begin, _pos).
+  /// Lexemes of errors are written to _value, lexemes of strings are their text without the quotes,
+  /// lexemes of other tokens are their text.
+  Token::Type Scan();
+
+  /// Scan for the streaming mode: a token which reaches the end of the window may continue in the unread input,
+  /// so the window is refilled and the token is scanned again
+  Token::Type ScanStream();
+
+  /// Drops the scanned text from the window and reads more input, at least as much as the window holds
+  void Refill();
+
   void SkipWs();
-  Token SkipComment();
+  void SkipLineComment();
+  std::optional<Token::Type> SkipComment();
+
+  std::optional<Token::Type> GetSpecial();
+  std::optional<Token::Type> GetIntLiteral();
+  std::optional<Token::Type> GetStringLiteral();
+  std::optional<Token::Type> CheckInvalid(char ch);
+
+  /// longest string literal after escape sequences are joined
+  static constexpr std::size_t kMaxStringLength = 1024;
 
-  std::optional<Token> GetSpecial();
-  std::optional<Token> GetKeyword(const std::string& keyword);
-  std::optional<Token> GetIntLiteral();
-  std::optional<Token> GetStringLiteral();
-  std::optional<Token> CheckInvalid(char ch);
+  /// skip characters after null character in string
+  void SkipAfterNull();
 
-  Token MakeToken(Token::Type type);
-  Token MakeToken(Token::Type type, std::string lexeme);
+  bool Eof() const {
+    return _pos >= _source.size();
+  }
+
+  /// returns character at _pos + offset or EOF if it is out of range
+  int Peek(std::size_t offset = 0) const {
+    return _pos + offset < _source.size() ? static_cast<unsigned char>(_source[_pos + offset])
+                                          : std::char_traits<char>::eof();
+  }
+
+  Token::Type MakeError(std::string_view message);
 
   uint32_t _current_line;
-  std::stringstream _sstream;
+  std::shared_ptr<const std::string> _storage;
+  std::string_view _source;
+  std::size_t _pos;
+  std::size_t _token_begin{0};
+  std::string _value;
+  bool _has_value{false};
+  const scan::Kernels* _scan;
+
+  /// streaming mode
+  int _fd{-1};
+  std::size_t _chunk_size{0};
+  std::string _window;
+  bool _input_eof{true};
 };
 
 }  // namespace coolc
@@ -0,0 +1,279 @@
+#include "lexer/scan.hpp"
+
+#include <cstdint>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define COOLC_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace coolc::scan {
+
+namespace {
+
+/// same set as std::isspace in "C" locale: ' ', '\t', '\n', '\v', '\f', '\r'
+constexpr bool IsSpace(char ch) {
+  return ch == ' ' || static_cast<unsigned char>(ch - '\t') <= '\r' - '\t';
+}
+
+constexpr bool IsWordChar(char ch) {
+  return static_cast<unsigned char>((ch | 0x20) - 'a') <= 'z' - 'a' ||
+         static_cast<unsigned char>(ch - '0') <= '9' - '0' || ch == '_';
+}
+
+const char* SkipWhitespaceScalar(const char* begin, const char* end, std::uint32_t* lines) {
+  for (; begin != end && IsSpace(*begin); ++begin) {
+    *lines += *begin == '\n';
+  }
+  return begin;
+}
+
+const char* FindWordEndScalar(const char* begin, const char* end) {
+  while (begin != end && IsWordChar(*begin)) {
+    ++begin;
+  }
+  return begin;
+}
+
+const char* FindCommentDelimiterScalar(const char* begin, const char* end) {
+  for (; begin != end; ++begin) {
+    if (*begin == '\n') {
+      return begin;
+    }
+    if (begin + 1 != end &&
+        ((begin[0] == '(' && begin[1] == '*') || (begin[0] == '*' && begin[1] == ')'))) {
+      return begin;
+    }
+  }
+  return end;
+}
+
+const char* FindStringSpecialScalar(const char* begin, const char* end) {
+  while (begin != end && *begin != '"' && *begin != '\\' && *begin != '\n' && *begin != '\0') {
+    ++begin;
+  }
+  return begin;
+}
+
+#ifdef COOLC_SCAN_X86
+
+/// Range checks are done with unsigned saturating min: x - lo <= hi - lo  <=>  min(x - lo, hi - lo) == x - lo
+/// Runs between tokens are usually a single character, so the first one is checked before loading a vector.
+
+const char* SkipWhitespaceSse2(const char* begin, const char* end, std::uint32_t* lines) {
+  if (begin == end || !IsSpace(*begin)) {
+    return begin;
+  }
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i newline = _mm_set1_epi8('\n');
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i control_range = _mm_set1_epi8('\r' - '\t');
+  for (; end - begin >= 16; begin += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+    __m128i control = _mm_sub_epi8(chunk, tab);
+    __m128i is_space = _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(control, control_range), control),
+                                    _mm_cmpeq_epi8(chunk, space));
+    auto spaces = static_cast<std::uint32_t>(_mm_movemask_epi8(is_space));
+    auto newlines = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+    if (spaces != 0xFFFF) {
+      auto stop = __builtin_ctz(~spaces);
+      *lines += __builtin_popcount(newlines & ((1u << stop) - 1));
+      return begin + stop;
+    }
+    *lines += __builtin_popcount(newlines);
+  }
+  return SkipWhitespaceScalar(begin, end, lines);
+}
+
+const char* FindWordEndSse2(const char* begin, const char* end) {
+  if (begin == end || !IsWordChar(*begin)) {
+    return begin;
+  }
+  const __m128i to_lower = _mm_set1_epi8(0x20);
+  const __m128i letter_a = _mm_set1_epi8('a');
+  const __m128i letter_range = _mm_set1_epi8('z' - 'a');
+  const __m128i digit_0 = _mm_set1_epi8('0');
+  const __m128i digit_range = _mm_set1_epi8('9' - '0');
+  const __m128i underscore = _mm_set1_epi8('_');
+  for (; end - begin >= 16; begin += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+    __m128i letter = _mm_sub_epi8(_mm_or_si128(chunk, to_lower), letter_a);
+    __m128i digit = _mm_sub_epi8(chunk, digit_0);
+    __m128i is_word = _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(letter, letter_range), letter),
+                                   _mm_cmpeq_epi8(_mm_min_epu8(digit, digit_range), digit));
+    is_word = _mm_or_si128(is_word, _mm_cmpeq_epi8(chunk, underscore));
+    auto word = static_cast<std::uint32_t>(_mm_movemask_epi8(is_word));
+    if (word != 0xFFFF) {
+      return begin + __builtin_ctz(~word);
+    }
+  }
+  return FindWordEndScalar(begin, end);
+}
+
+const char* FindCommentDelimiterSse2(const char* begin, const char* end) {
+  const __m128i newline = _mm_set1_epi8('\n');
+  const __m128i lparen = _mm_set1_epi8('(');
+  const __m128i rparen = _mm_set1_epi8(')');
+  const __m128i star = _mm_set1_epi8('*');
+  // the second character of a delimiter is read from the next byte, so keep one byte after the chunk
+  for (; end - begin >= 17; begin += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+    __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin + 1));
+    __m128i open = _mm_and_si128(_mm_cmpeq_epi8(chunk, lparen), _mm_cmpeq_epi8(next, star));
+    __m128i close = _mm_and_si128(_mm_cmpeq_epi8(chunk, star), _mm_cmpeq_epi8(next, rparen));
+    __m128i found = _mm_or_si128(_mm_or_si128(open, close), _mm_cmpeq_epi8(chunk, newline));
+    if (auto mask = _mm_movemask_epi8(found); mask != 0) {
+      return begin + __builtin_ctz(mask);
+    }
+  }
+  return FindCommentDelimiterScalar(begin, end);
+}
+
+const char* FindStringSpecialSse2(const char* begin, const char* end) {
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i newline = _mm_set1_epi8('\n');
+  const __m128i zero = _mm_setzero_si128();
+  for (; end - begin >= 16; begin += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+    __m128i found = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+                                 _mm_or_si128(_mm_cmpeq_epi8(chunk, newline), _mm_cmpeq_epi8(chunk, zero)));
+    if (auto mask = _mm_movemask_epi8(found); mask != 0) {
+      return begin + __builtin_ctz(mask);
+    }
+  }
+  return FindStringSpecialScalar(begin, end);
+}
+
+__attribute__((target("avx2"))) const char* SkipWhitespaceAvx2(const char* begin, const char* end,
+                                                               std::uint32_t* lines) {
+  if (begin == end || !IsSpace(*begin)) {
+    return begin;
+  }
+  const __m256i space = _mm256_set1_epi8(' ');
+  const __m256i newline = _mm256_set1_epi8('\n');
+  const __m256i tab = _mm256_set1_epi8('\t');
+  const __m256i control_range = _mm256_set1_epi8('\r' - '\t');
+  for (; end - begin >= 32; begin += 32) {
+    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+    __m256i control = _mm256_sub_epi8(chunk, tab);
+    __m256i is_space = _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(control, control_range), control),
+                                       _mm256_cmpeq_epi8(chunk, space));
+    auto spaces = static_cast<std::uint32_t>(_mm256_movemask_epi8(is_space));
+    auto newlines = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline)));
+    if (spaces != 0xFFFFFFFF) {
+      auto stop = __builtin_ctz(~spaces);
+      *lines += __builtin_popcount(newlines & ((std::uint64_t{1} << stop) - 1));
+      return begin + stop;
+    }
+    *lines += __builtin_popcount(newlines);
+  }
+  return SkipWhitespaceSse2(begin, end, lines);
+}
+
+__attribute__((target("avx2"))) const char* FindWordEndAvx2(const char* begin, const char* end) {
+  if (begin == end || !IsWordChar(*begin)) {
+    return begin;
+  }
+  const __m256i to_lower = _mm256_set1_epi8(0x20);
+  const __m256i letter_a = _mm256_set1_epi8('a');
+  const __m256i letter_range = _mm256_set1_epi8('z' - 'a');
+  const __m256i digit_0 = _mm256_set1_epi8('0');
+  const __m256i digit_range = _mm256_set1_epi8('9' - '0');
+  const __m256i underscore = _mm256_set1_epi8('_');
+  for (; end - begin >= 32; begin += 32) {
+    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+    __m256i letter = _mm256_sub_epi8(_mm256_or_si256(chunk, to_lower), letter_a);
+    __m256i digit = _mm256_sub_epi8(chunk, digit_0);
+    __m256i is_word = _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(letter, letter_range), letter),
+                                      _mm256_cmpeq_epi8(_mm256_min_epu8(digit, digit_range), digit));
+    is_word = _mm256_or_si256(is_word, _mm256_cmpeq_epi8(chunk, underscore));
+    auto word = static_cast<std::uint32_t>(_mm256_movemask_epi8(is_word));
+    if (word != 0xFFFFFFFF) {
+      return begin + __builtin_ctz(~word);
+    }
+  }
+  return FindWordEndSse2(begin, end);
+}
+
+__attribute__((target("avx2"))) const char* FindCommentDelimiterAvx2(const char* begin, const char* end) {
+  const __m256i newline = _mm256_set1_epi8('\n');
+  const __m256i lparen = _mm256_set1_epi8('(');
+  const __m256i rparen = _mm256_set1_epi8(')');
+  const __m256i star = _mm256_set1_epi8('*');
+  for (; end - begin >= 33; begin += 32) {
+    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+    __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin + 1));
+    __m256i open = _mm256_and_si256(_mm256_cmpeq_epi8(chunk, lparen), _mm256_cmpeq_epi8(next, star));
+    __m256i close = _mm256_and_si256(_mm256_cmpeq_epi8(chunk, star), _mm256_cmpeq_epi8(next, rparen));
+    __m256i found = _mm256_or_si256(_mm256_or_si256(open, close), _mm256_cmpeq_epi8(chunk, newline));
+    if (auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(found)); mask != 0) {
+      return begin + __builtin_ctz(mask);
+    }
+  }
+  return FindCommentDelimiterSse2(begin, end);
+}
+
+__attribute__((target("avx2"))) const char* FindStringSpecialAvx2(const char* begin, const char* end) {
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  const __m256i newline = _mm256_set1_epi8('\n');
+  const __m256i zero = _mm256_setzero_si256();
+  for (; end - begin >= 32; begin += 32) {
+    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+    __m256i found =
+        _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)),
+                        _mm256_or_si256(_mm256_cmpeq_epi8(chunk, newline), _mm256_cmpeq_epi8(chunk, zero)));
+    if (auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(found)); mask != 0) {
+      return begin + __builtin_ctz(mask);
+    }
+  }
+  return FindStringSpecialSse2(begin, end);
+}
+
+#endif
+
+}  // namespace
+
+const Kernels& ScalarKernels() {
+  static constexpr Kernels kernels{"scalar", SkipWhitespaceScalar, FindWordEndScalar, FindCommentDelimiterScalar,
+                                   FindStringSpecialScalar};
+  return kernels;
+}
+
+const Kernels* Sse2Kernels() {
+#ifdef COOLC_SCAN_X86
+  static constexpr Kernels kernels{"sse2", SkipWhitespaceSse2, FindWordEndSse2, FindCommentDelimiterSse2,
+                                   FindStringSpecialSse2};
+  if (__builtin_cpu_supports("sse2")) {
+    return &kernels;
+  }
+#endif
+  return nullptr;
+}
+
+const Kernels* Avx2Kernels() {
+#ifdef COOLC_SCAN_X86
+  static constexpr Kernels kernels{"avx2", SkipWhitespaceAvx2, FindWordEndAvx2, FindCommentDelimiterAvx2,
+                                   FindStringSpecialAvx2};
+  if (__builtin_cpu_supports("avx2")) {
+    return &kernels;
+  }
+#endif
+  return nullptr;
+}
+
+const Kernels& Dispatch() {
+  static const Kernels& kernels = []() -> const Kernels& {
+    if (const auto* avx2 = Avx2Kernels(); avx2) {
+      return *avx2;
+    }
+    if (const auto* sse2 = Sse2Kernels(); sse2) {
+      return *sse2;
+    }
+    return ScalarKernels();
+  }();
+  return kernels;
+}
+
+}  // namespace coolc::scan
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+namespace coolc::scan {
+
+/// Bulk scanning kernels for the hot loops of the lexer.
+/// Every kernel scans [begin, end) and returns pointer to the first character which stops the scan or end.
+struct Kernels {
+  const char* name;
+
+  /// first character which is not a whitespace, number of skipped '\n' is added to *lines
+  const char* (*skip_whitespace)(const char* begin, const char* end, std::uint32_t* lines);
+
+  /// first character which is not [A-Za-z0-9_]
+  const char* (*find_word_end)(const char* begin, const char* end);
+
+  /// first "(*", "*)" or '\n' inside of the multiline comment
+  const char* (*find_comment_delimiter)(const char* begin, const char* end);
+
+  /// first '"', '\\', '\n' or '\0' inside of the string literal
+  const char* (*find_string_special)(const char* begin, const char* end);
+};
+
+const Kernels& ScalarKernels();
+
+/// nullptr if the compiler or the CPU doesn't support the instruction set
+const Kernels* Sse2Kernels();
+const Kernels* Avx2Kernels();
+
+/// the widest kernels supported by the current CPU, selected once at the first call
+const Kernels& Dispatch();
+
+}  // namespace coolc::scan
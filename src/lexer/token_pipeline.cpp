@@ -0,0 +1,64 @@
+#include "lexer/token_pipeline.hpp"
+
+#include "lexer/lexer.hpp"
+#include "token/token.hpp"
+#include "token/token_stream.hpp"
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace coolc {
+
+namespace {
+
+bool IsEnd(const Token& token) {
+  return token.type == Token::Type::Unknown && !token.lexeme;
+}
+
+}  // namespace
+
+TokenPipeline::TokenPipeline(Lexer& lexer, std::size_t batch_size, std::size_t queue_capacity)
+    : _queue{queue_capacity}, _producer{[this, &lexer, batch_size] { Produce(lexer, batch_size); }} {
+}
+
+TokenPipeline::~TokenPipeline() {
+  // the lexer checks the flag between batches, draining unblocks it if the queue is full
+  _stop.store(true, std::memory_order_relaxed);
+  while (!_finished) {
+    Next();
+  }
+  _producer.join();
+}
+
+TokenStream TokenPipeline::Stream() {
+  return TokenStream{[this] { return Next(); }};
+}
+
+void TokenPipeline::Produce(Lexer& lexer, std::size_t batch_size) {
+  bool end = false;
+  while (!end) {
+    std::vector<Token> batch;
+    batch.reserve(batch_size);
+    while (batch.size() < batch_size && !end) {
+      batch.push_back(_stop.load(std::memory_order_relaxed) ? Token{} : lexer.NextToken());
+      end = IsEnd(batch.back());
+    }
+    _queue.Push(std::move(batch));
+  }
+}
+
+Token TokenPipeline::Next() {
+  if (_finished) {
+    return Token{};
+  }
+  if (_next == _batch.size()) {
+    _batch = _queue.Pop();
+    _next = 0;
+  }
+  auto token = _batch[_next++];
+  _finished = IsEnd(token);
+  return token;
+}
+
+}  // namespace coolc
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "lexer/lexer.hpp"
+#include "token/token.hpp"
+#include "token/token_stream.hpp"
+#include "util/spsc_queue.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace coolc {
+
+/// Runs a lexer on its own thread ahead of the parser: tokens are passed in batches through a single-producer
+/// single-consumer queue, so lexing overlaps with parsing and the front end takes about max(lex, parse).
+/// The last batch ends with the end of file token. The lexer must outlive the pipeline and must not be used by
+/// anyone else while the pipeline exists.
+class TokenPipeline {
+ public:
+  static constexpr std::size_t kDefaultBatchSize = 1024;
+  static constexpr std::size_t kDefaultQueueCapacity = 64;
+
+  explicit TokenPipeline(Lexer& lexer, std::size_t batch_size = kDefaultBatchSize,
+                         std::size_t queue_capacity = kDefaultQueueCapacity);
+  /// Stops the lexer if the consumer has not reached the end of file and joins it
+  ~TokenPipeline();
+
+  TokenPipeline(const TokenPipeline&) = delete;
+  TokenPipeline& operator=(const TokenPipeline&) = delete;
+
+  /// Consumer side of the pipeline, only one stream may be taken and the pipeline must outlive it
+  TokenStream Stream();
+
+ private:
+  void Produce(Lexer& lexer, std::size_t batch_size);
+  Token Next();
+
+  util::SpscQueue<std::vector<Token>> _queue;
+  std::atomic<bool> _stop{false};
+  std::vector<Token> _batch;
+  std::size_t _next{0};
+  bool _finished{false};
+  std::thread _producer;
+};
+
+}  // namespace coolc
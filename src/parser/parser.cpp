@@ -1,28 +1,405 @@
 #include "parser/parser.hpp"
 
 #include "ast/expression.hpp"
+#include "token/string_literal.hpp"
 #include "token/token.hpp"
+#include "token/token_buffer.hpp"
+#include "token/token_stream.hpp"
+#include "util/arena.hpp"
+#include "util/thread_pool.hpp"
+#include "util/type_traits.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <future>
 #include <iostream>
+#include <iterator>
 #include <memory>
 #include <optional>
+#include <span>
 #include <string>
+#include <type_traits>
+#include <utility>
+#include <variant>
 #include <vector>
 
 namespace coolc {
 
-Parser::Parser(const std::vector<Token>& tokens, std::string filename)
-    : filename_(std::move(filename)), next_{tokens.cbegin()} {
+namespace {
+
+constexpr int kLowestPrecedence = 0;
+constexpr int kComparisonPrecedence = 1;
+/// ~ and isvoid bind tighter than any binary operator
+constexpr int kUnaryPrecedence = 4;
+
+/// precedence of the binary operators, zero for other tokens
+constexpr auto kPrecedence = [] {
+  std::array<int, static_cast<std::size_t>(Token::Type::Size)> table{};
+  auto set = [&table](Token::Type type, int precedence) { table[static_cast<std::size_t>(type)] = precedence; };
+  set(Token::Type::Less, kComparisonPrecedence);
+  set(Token::Type::Leq, kComparisonPrecedence);
+  set(Token::Type::Equals, kComparisonPrecedence);
+  set(Token::Type::Plus, 2);
+  set(Token::Type::Minus, 2);
+  set(Token::Type::Mul, 3);
+  set(Token::Type::Slash, 3);
+  return table;
+}();
+
+constexpr int Precedence(Token::Type type) {
+  return kPrecedence[static_cast<std::size_t>(type)];
+}
+
+static_assert(Precedence(Token::Type::Mul) > Precedence(Token::Type::Plus));
+static_assert(Precedence(Token::Type::Assign) == 0);
+
+bool IsEnd(const Token& token) {
+  return token.type == Token::Type::Unknown && !token.lexeme;
+}
+
+/// the token as the reference parser prints it in syntax errors
+std::string Near(const Token& token) {
+  switch (token.type) {
+    case Token::Type::Unknown:
+      return token.lexeme ? "ERROR = \"" + token.lexeme->Str() + "\"" : "EOF";
+    case Token::Type::TypeID:
+    case Token::Type::ObjectID:
+    case Token::Type::Integer:
+      return std::string{Token::ToString(token.type)} + " = " + token.lexeme->Str();
+    case Token::Type::String:
+      return "STR_CONST = \"" + EscapeStringLiteral(token.lexeme->View()) + "\"";
+    case Token::Type::True:
+      return "BOOL_CONST = true";
+    case Token::Type::False:
+      return "BOOL_CONST = false";
+    default:
+      return Token::ToString(token.type);
+  }
+}
+
+std::size_t ShiftLine(std::size_t line, std::ptrdiff_t delta) {
+  return static_cast<std::size_t>(static_cast<std::ptrdiff_t>(line) + delta);
+}
+
+/// moves the nodes of the tree by delta lines, without recursion as the tree may be deep
+void ShiftLines(Expression* root, std::ptrdiff_t delta) {
+  std::vector<Expression*> stack{root};
+  while (!stack.empty()) {
+    auto* expr = stack.back();
+    stack.pop_back();
+    std::visit(
+        [&](auto& node) {
+          using T = std::remove_cvref_t<decltype(node)>;
+          node.line_number = ShiftLine(node.line_number, delta);
+          if constexpr (UnaryExpressionT<T>) {
+            stack.push_back(node.arg);
+          } else if constexpr (BinaryExpressionT<T>) {
+            stack.push_back(node.lhs);
+            stack.push_back(node.rhs);
+          } else if constexpr (std::is_same_v<T, Assign>) {
+            stack.push_back(node.rhs);
+          } else if constexpr (std::is_same_v<T, If>) {
+            stack.insert(stack.end(), {node.condition, node.then_expr, node.else_expr});
+          } else if constexpr (std::is_same_v<T, While>) {
+            stack.insert(stack.end(), {node.condition, node.loop_body});
+          } else if constexpr (std::is_same_v<T, Block>) {
+            stack.insert(stack.end(), node.expr.begin(), node.expr.end());
+          } else if constexpr (std::is_same_v<T, Dispatch>) {
+            node.object_id->line_number = ShiftLine(node.object_id->line_number, delta);
+            stack.push_back(node.expr);
+            stack.insert(stack.end(), node.parameters.begin(), node.parameters.end());
+          } else if constexpr (util::IsOneOfV<T, Let, Case>) {
+            stack.push_back(node.expr);
+            std::span<Attribute> bindings;
+            if constexpr (std::is_same_v<T, Let>) {
+              bindings = node.attrs;
+            } else {
+              bindings = node.cases;
+            }
+            for (auto& binding : bindings) {
+              binding.line_number = ShiftLine(binding.line_number, delta);
+              stack.push_back(binding.expr);
+            }
+          }
+        },
+        expr->data_);
+  }
+}
+
+std::size_t FeatureLine(const Feature& feature) {
+  return std::visit([](const auto& node) { return node.line_number; }, feature.feature);
+}
+
+void ShiftLines(Feature* feature, std::ptrdiff_t delta) {
+  std::visit(
+      [delta](auto& node) {
+        node.line_number = ShiftLine(node.line_number, delta);
+        if constexpr (std::is_same_v<std::remove_cvref_t<decltype(node)>, Method>) {
+          for (auto& formal : node.formals) {
+            formal.line_number = ShiftLine(formal.line_number, delta);
+          }
+        }
+        ShiftLines(node.expr, delta);
+      },
+      feature->feature);
+}
+
+}  // namespace
+
+Parser::Parser(const TokenBuffer& tokens, std::string filename, ErrorMode mode)
+    : Parser(TokenStream{tokens}, std::move(filename), mode) {
+  tokens_ = &tokens;
+}
+
+Parser::Parser(TokenStream tokens, std::string filename, ErrorMode mode)
+    : filename_(std::move(filename)), next_{std::move(tokens)}, mode_{mode} {
 }
 
 Program Parser::ParseProgram() {
+  class_spans_.clear();
+  feature_spans_.clear();
+  Program res;
+  res.arena = std::make_unique<util::Arena>();
+  arena_ = res.arena.get();
+  res.line_number = next_->line;
+  ParseClasses(&res);
+  return res;
+}
+
+void Parser::ParseClasses(Program* res) {
+  ParseClassList(&res->classes, kNoEnd);
+  try {
+    // an empty program is an error at the end of file, unless its classes had errors of their own
+    Assert(!res->classes.empty() || !diagnostics_.empty());
+  } catch (const SyntaxError&) {
+  }
+}
+
+void Parser::ParseClassList(std::vector<Class>* classes, std::size_t end) {
+  while (!IsEnd(*next_) && Index() < end) {
+    auto begin = Index();
+    if (auto* reused = TakeReusable(&reusable_classes_, &next_reusable_class_, begin)) {
+      // a run of unchanged classes is taken without reading its tokens
+      while (reused != nullptr) {
+        auto& res = classes->emplace_back(std::move(*reused->node));
+        auto delta = static_cast<std::ptrdiff_t>(tokens_->Line(begin)) - static_cast<std::ptrdiff_t>(res.line_number);
+        if (delta != 0) {
+          res.line_number = ShiftLine(res.line_number, delta);
+          for (auto& feature : res.features) {
+            ShiftLines(&feature, delta);
+          }
+        }
+        class_spans_.push_back(reused->span);
+        for (auto span : reused->features) {
+          feature_spans_.push_back({span.begin + reused->offset, span.end + reused->offset, true});
+        }
+        begin = reused->span.end;
+        reused = begin < end ? TakeReusable(&reusable_classes_, &next_reusable_class_, begin) : nullptr;
+      }
+      Seek(begin);
+      continue;
+    }
+    auto diagnostics = diagnostics_.size();
+    auto features = feature_spans_.size();
+    try {
+      classes->push_back(ParseClass());
+      AssertMatch(Token::Type::Semicolon);
+      class_spans_.push_back({begin, Index(), diagnostics_.size() == diagnostics});
+    } catch (const SyntaxError&) {
+      if (mode_ != ErrorMode::Recover) {
+        throw;
+      }
+      if (classes->size() > class_spans_.size()) {
+        // the class is kept without its ';'
+        class_spans_.push_back({begin, Index(), false});
+      } else {
+        feature_spans_.resize(features);
+      }
+      SynchronizeClass();
+    }
+  }
+}
+
+Program Parser::Reparse(Program previous, const TokenBuffer::Change& change) {
+  assert(tokens_ != nullptr && class_spans_.size() == previous.classes.size());
+  auto shift = static_cast<std::ptrdiff_t>(change.inserted) - static_cast<std::ptrdiff_t>(change.removed);
+  // offset of a span in the new tokens, if the tokens of the span are unchanged
+  auto offset = [&](const Span& span) -> std::optional<std::ptrdiff_t> {
+    if (!span.clean) {
+      return {};
+    }
+    if (span.end <= change.first) {
+      return 0;
+    }
+    if (span.begin >= change.first + change.removed) {
+      return shift;
+    }
+    return {};
+  };
+  auto moved = [](const Span& span, std::ptrdiff_t offset) {
+    return Span{span.begin + offset, span.end + offset, span.clean};
+  };
+
+  auto class_spans = std::move(class_spans_);
+  auto feature_spans = std::move(feature_spans_);
+  class_spans_.clear();
+  feature_spans_.clear();
+  std::span<const Span> features{feature_spans};
+  for (std::size_t i = 0; i < previous.classes.size(); ++i) {
+    auto& cl = previous.classes[i];
+    auto spans = features.subspan(0, cl.features.size());
+    features = features.subspan(spans.size());
+    if (auto class_offset = offset(class_spans[i])) {
+      reusable_classes_.push_back({moved(class_spans[i], *class_offset), &cl, spans, *class_offset});
+    }
+    for (std::size_t j = 0; j < spans.size(); ++j) {
+      if (auto feature_offset = offset(spans[j])) {
+        reusable_features_.push_back({moved(spans[j], *feature_offset), &cl.features[j]});
+      }
+    }
+  }
+
+  Program res;
+  res.arena = std::move(previous.arena);
+  arena_ = res.arena.get();
+  Seek(0);
+  diagnostics_.clear();
+  braces_ = 0;
+  quiet_until_ = 0;
+  res.line_number = next_->line;
+  ParseClasses(&res);
+  reusable_classes_.clear();
+  reusable_features_.clear();
+  next_reusable_class_ = next_reusable_feature_ = 0;
+  return res;
+}
+
+void Parser::Seek(std::size_t index) {
+  next_ = TokenStream{*tokens_, index};
+  first_ = index;
+}
+
+template <typename T>
+T* Parser::TakeReusable(std::vector<T>* items, std::size_t* next, std::size_t index) {
+  while (*next < items->size() && (*items)[*next].span.begin < index) {
+    ++*next;
+  }
+  if (*next == items->size() || (*items)[*next].span.begin != index) {
+    return nullptr;
+  }
+  return &(*items)[(*next)++];
+}
+
+struct Parser::Chunk {
+  std::size_t begin{0};
+  /// token after the last parsed class
+  std::size_t end{0};
+  std::vector<Class> classes{};
+  std::unique_ptr<util::Arena> arena{};
+  std::vector<Diagnostic> diagnostics{};
+  std::vector<Span> class_spans{};
+  std::vector<Span> feature_spans{};
+  /// the error which has stopped the chunk in the Halt mode
+  std::optional<std::size_t> error_line{};
+  /// state of the parser at the end, the next chunk has started without it
+  std::size_t quiet_until{0};
+  std::size_t braces{0};
+};
+
+Parser::Chunk Parser::ParseChunk(const TokenBuffer& tokens, const std::string& filename, ErrorMode mode,
+                                 std::size_t begin, std::size_t end) {
+  Chunk chunk{.begin = begin, .end = begin, .arena = std::make_unique<util::Arena>()};
+  Parser parser(TokenStream{tokens, begin}, filename, mode);
+  parser.first_ = begin;
+  parser.arena_ = chunk.arena.get();
+  parser.throw_errors_ = true;
+  try {
+    parser.ParseClassList(&chunk.classes, end);
+  } catch (const SyntaxError& error) {
+    chunk.error_line = error.line;
+  }
+  chunk.end = parser.Index();
+  chunk.quiet_until = parser.quiet_until_;
+  chunk.braces = parser.braces_;
+  chunk.diagnostics = std::move(parser.diagnostics_);
+  chunk.class_spans = std::move(parser.class_spans_);
+  chunk.feature_spans = std::move(parser.feature_spans_);
+  return chunk;
+}
+
+Program Parser::ParseProgram(util::ThreadPool& pool, std::size_t min_classes) {
+  if (tokens_ == nullptr || Index() > 0) {
+    return ParseProgram();
+  }
+  class_spans_.clear();
+  feature_spans_.clear();
+  // a class keyword outside of braces is where the serial parser starts a class, unless an error comes first
+  std::vector<std::size_t> starts;
+  std::size_t depth = 0;
+  for (std::size_t i = 0; i < tokens_->size(); ++i) {
+    switch (tokens_->Kind(i)) {
+      case Token::Type::LBrace:
+        ++depth;
+        break;
+      case Token::Type::RBrace:
+        if (depth > 0) {
+          --depth;
+        }
+        break;
+      case Token::Type::Class:
+        if (depth == 0) {
+          starts.push_back(i);
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  auto count = std::clamp<std::size_t>(starts.size() / std::max<std::size_t>(min_classes, 1), 1, pool.Size());
+  if (count == 1 || starts.front() != 0) {
+    return ParseProgram();
+  }
+
+  std::vector<std::future<Chunk>> chunks;
+  for (std::size_t i = 0; i < count; ++i) {
+    auto begin = starts[starts.size() * i / count];
+    auto end = i + 1 < count ? starts[starts.size() * (i + 1) / count] : tokens_->size();
+    chunks.push_back(pool.Submit([tokens = tokens_, &filename = filename_, mode = mode_, begin, end] {
+      return ParseChunk(*tokens, filename, mode, begin, end);
+    }));
+  }
+
   Program res;
+  res.arena = std::make_unique<util::Arena>();
+  arena_ = res.arena.get();
   res.line_number = next_->line;
-  while (next_->type == Token::Type::Class) {
-    res.classes.emplace_back(ParseClass());
-    AssertMatch(Token::Type::Semicolon);
+  // every chunk is waited for before an error terminates the program
+  std::vector<Chunk> parsed;
+  for (auto& future : chunks) {
+    parsed.push_back(future.get());
+  }
+  std::size_t pos = 0;
+  for (auto& chunk : parsed) {
+    // a chunk has started in the initial state, it is taken only if the serial parse reaches it in that state too
+    if (chunk.begin != pos || quiet_until_ > pos || braces_ > 0) {
+      break;
+    }
+    res.arena->Merge(std::move(*chunk.arena));
+    std::move(chunk.classes.begin(), chunk.classes.end(), std::back_inserter(res.classes));
+    std::move(chunk.diagnostics.begin(), chunk.diagnostics.end(), std::back_inserter(diagnostics_));
+    class_spans_.insert(class_spans_.end(), chunk.class_spans.begin(), chunk.class_spans.end());
+    feature_spans_.insert(feature_spans_.end(), chunk.feature_spans.begin(), chunk.feature_spans.end());
+    if (chunk.error_line) {
+      Fail(*chunk.error_line);
+    }
+    pos = chunk.end;
+    quiet_until_ = chunk.quiet_until;
+    braces_ = chunk.braces;
   }
-  Assert(res.classes.size() > 0 && next_->type == Token::Type::Unknown);
+  // the rest goes on from the state of the last chunk taken
+  Seek(pos);
+  ParseClasses(&res);
   return res;
 }
 
@@ -39,49 +416,69 @@ Class Parser::ParseClass() {
     res.inherits_type = *next_->lexeme;
     next_++;
   } else {
-    res.inherits_type = "Object";
+    res.inherits_type = symbols::kObject;
   }
   AssertMatch(Token::Type::LBrace);
 
-  for (auto feature_ = ParseFeature(); feature_; feature_ = ParseFeature()) {
-    res.features.push_back(*feature_);
-    AssertMatch(Token::Type::Semicolon);
+  auto spans = feature_spans_.size();
+  while (next_->type != Token::Type::RBrace) {
+    auto begin = Index();
+    if (auto* reused = TakeReusable(&reusable_features_, &next_reusable_feature_, begin)) {
+      while (reused != nullptr) {
+        auto& feature = res.features.emplace_back(std::move(*reused->node));
+        auto delta =
+            static_cast<std::ptrdiff_t>(tokens_->Line(begin)) - static_cast<std::ptrdiff_t>(FeatureLine(feature));
+        if (delta != 0) {
+          ShiftLines(&feature, delta);
+        }
+        feature_spans_.push_back(reused->span);
+        begin = reused->span.end;
+        reused = TakeReusable(&reusable_features_, &next_reusable_feature_, begin);
+      }
+      Seek(begin);
+      continue;
+    }
+    auto diagnostics = diagnostics_.size();
+    auto stacks = Stacks();
+    try {
+      res.features.push_back(ParseFeature());
+      AssertMatch(Token::Type::Semicolon);
+      feature_spans_.push_back({begin, Index(), diagnostics_.size() == diagnostics});
+    } catch (const SyntaxError&) {
+      if (res.features.size() > feature_spans_.size() - spans) {
+        // the feature is kept without its ';'
+        feature_spans_.push_back({begin, Index(), false});
+      }
+      if (!Synchronize(stacks)) {
+        throw;
+      }
+    }
   }
 
   AssertMatch(Token::Type::RBrace);
   return res;
 }
 
-std::optional<Feature> Parser::ParseFeature() {
+Feature Parser::ParseFeature() {
   Feature res;
-  if (next_->type != Token::Type::ObjectID) {
-    return {};
-  }
-  if (std::next(next_)->type == Token::Type::LParen) {
+  Assert(next_->type == Token::Type::ObjectID);
+  if (next_.Peek(1).type == Token::Type::LParen) {
     res.feature = ParseMethodFeature();
-    return {std::move(res)};
-  } else if (std::next(next_)->type == Token::Type::Colon) {
+    return res;
+  } else if (next_.Peek(1).type == Token::Type::Colon) {
     res.feature = ParseAttributeFeature();
-    return {std::move(res)};
+    return res;
   }
   Assert(false);
-  return {};  // unreachable code, just to avoid warnings
+  return res;  // unreachable code, just to avoid warnings
 }
 
 Attribute Parser::ParseAttributeFeature() {
-  Assert(next_->type == Token::Type::ObjectID);
-  Attribute res;
-  res.line_number = next_->line;
-  res.object_id = *next_->lexeme;
-  next_++;
-  AssertMatch(Token::Type::Colon);
-  Assert(next_->type == Token::Type::TypeID);
-  res.type_id = *next_->lexeme;
-  next_++;
+  auto res = ParseBinding();
   if (Match(Token::Type::Assign)) {
-    res.expr = std::make_shared<Expression>(ParseExpression());
+    res.expr = Make(ParseExpression());
   } else {
-    res.expr = std::make_shared<Expression>(Empty{});
+    res.expr = Make(Empty{});
   }
   return res;
 }
@@ -115,7 +512,7 @@ Method Parser::ParseMethodFeature() {
   res.type_id = *next_->lexeme;
   next_++;
   AssertMatch(Token::Type::LBrace);
-  res.expr = std::make_shared<Expression>(ParseExpression());
+  res.expr = Make(ParseExpression());
   AssertMatch(Token::Type::RBrace);
   return res;
 }
@@ -135,312 +532,521 @@ std::optional<Formal> Parser::ParseFormal() {
   return {std::move(res)};
 }
 
-/// Sorted by priority from lowest to highest
-/// Id <- expr
-Expression Parser::ParseAssign() {
-  if (next_->type != Token::Type::ObjectID) {
-    return ParseNot();
-  }
-  Assign res;
+Attribute Parser::ParseBinding() {
+  Assert(next_->type == Token::Type::ObjectID);
+  Attribute res;
   res.line_number = next_->line;
-  res.identifier = *next_->lexeme;
-  if (std::next(next_)->type != Token::Type::Assign) {
-    return ParseNot();
-  }
-  next_ += 2;
-  auto expr = ParseAssign();
-  res.rhs = std::make_shared<Expression>(expr);
-  return {std::move(res)};
+  res.object_id = *next_->lexeme;
+  next_++;
+  AssertMatch(Token::Type::Colon);
+  Assert(next_->type == Token::Type::TypeID);
+  res.type_id = *next_->lexeme;
+  next_++;
+  return res;
 }
 
-/// Not expr
-Expression Parser::ParseNot() {
-  if (next_->type != Token::Type::Not) {
-    return ParseComparisons();
+/// Expressions are parsed by precedence climbing over explicit stacks, so no expression recurses however deep it is.
+/// Operators are on the operator stack and parenthesized expressions are frames. An if, while, let, case, block or
+/// call with arguments is a compound whose nested expressions are frames of their own, the compound goes on when one
+/// ends. The grammar is that of the recursive descent from the lowest priority to the highest:
+///   expr       = Id <- expr | not-expr
+///   not-expr   = not not-expr | comparison
+///   comparison = arith [(<|<=|=) arith]
+///   arith      = arith (+|-|*|/) arith, * and / bind tighter, both left associative
+///   unary      = (~|isvoid) unary | dispatch
+/// so assignments are allowed only at the start of an expression and a comparison can't be chained.
+Expression Parser::ParseExpression() {
+  auto frames_base = frames_.size();
+  auto compounds_base = compounds_.size();
+  frames_.push_back({.operators = operators_.size()});
+  bool resume = false;
+  while (true) {
+    try {
+      return ParseFrames(frames_base, resume);
+    } catch (const SyntaxError&) {
+      // the innermost block goes on after its expression with the error, other errors are left to the caller
+      auto block = compounds_.size();
+      while (block > compounds_base && compounds_[block - 1].type != Token::Type::LBrace) {
+        --block;
+      }
+      if (block == compounds_base || !Synchronize(compounds_[block - 1].stacks)) {
+        throw;
+      }
+      compounds_.back().recovered = true;
+      resume = true;
+    }
   }
-  auto line = next_->line;
-  next_++;
-  return {Not{line, std::make_shared<Expression>(ParseNot())}};
 }
 
-/// expr (<|<=|=) expr
-Expression Parser::ParseComparisons() {
-  auto term = ParseAddSub();
-  auto line = next_->line;
-
-  if (Match(Token::Type::Less)) {
-    return {Less{line, std::make_shared<Expression>(std::move(term)), std::make_shared<Expression>(ParseAddSub())}};
-  }
-  if (Match(Token::Type::Equals)) {
-    return {Equal{line, std::make_shared<Expression>(std::move(term)), std::make_shared<Expression>(ParseAddSub())}};
-  }
-  if (Match(Token::Type::Leq)) {
-    return {LessEq{line, std::make_shared<Expression>(std::move(term)), std::make_shared<Expression>(ParseAddSub())}};
+Expression Parser::ParseFrames(std::size_t frames_base, bool resume) {
+  auto position = Position::Expression;
+  // the operand on top is complete, an operator or the end of its frame follows
+  bool complete = resume && Continue(nullptr);
+  while (true) {
+    if (!complete) {
+      ParsePrefixes(position);
+      if (!ParsePrimary()) {
+        position = Position::Expression;
+        continue;
+      }
+    }
+    complete = false;
+    while (true) {
+      auto& frame = frames_.back();
+      auto precedence = Precedence(next_->type);
+      bool comparison = precedence == kComparisonPrecedence;
+      if (precedence != 0 && !(comparison && frame.has_comparison)) {
+        frame.has_comparison |= comparison;
+        Reduce(frame.operators, precedence);
+        operators_.push_back({.type = next_->type, .line = next_->line, .precedence = precedence});
+        ++next_;
+        position = Position::Operand;
+        break;
+      }
+      Reduce(frame.operators, kLowestPrecedence);
+      if (frames_.size() == frames_base + 1) {
+        frames_.pop_back();
+        auto result = std::move(operands_.back());
+        operands_.pop_back();
+        return result;
+      }
+      if (!frame.nested) {
+        // end of a parenthesized expression, which is the atom of a dispatch
+        Assert(next_->type == Token::Type::RParen);
+        next_++;
+      }
+      auto nested = frame.nested;
+      auto line = frame.line;
+      frames_.pop_back();
+      auto value = std::move(operands_.back());
+      operands_.pop_back();
+      if (!(nested ? Continue(Make(std::move(value))) : ParseDispatch(std::move(value), line))) {
+        position = Position::Expression;
+        break;
+      }
+    }
   }
-  return term;
 }
 
-/// expr (+|-) expr
-Expression Parser::ParseAddSub() {
-  auto term = ParseMulDiv();
-  while (next_->type == Token::Type::Plus || next_->type == Token::Type::Minus) {
+/// Pushes prefix operators and opens parentheses until the start of a primary expression
+void Parser::ParsePrefixes(Position position) {
+  while (true) {
     auto line = next_->line;
-    auto type = next_->type;
-    ++next_;
-    auto next_term = ParseMulDiv();
-    auto lhs = std::make_shared<Expression>(std::move(term));
-    auto rhs = std::make_shared<Expression>(std::move(next_term));
-
-    if (type == Token::Type::Plus) {
-      term = {Plus{line, std::move(lhs), std::move(rhs)}};
+    if (position == Position::Expression && next_->type == Token::Type::ObjectID &&
+        next_.Peek(1).type == Token::Type::Assign) {
+      operators_.push_back({.type = Token::Type::Assign, .line = line, .identifier = *next_->lexeme});
+      next_ += 2;
+    } else if (position != Position::Operand && next_->type == Token::Type::Not) {
+      operators_.push_back({.type = Token::Type::Not, .line = line});
+      next_++;
+      position = Position::Not;
+    } else if (next_->type == Token::Type::Tilde || next_->type == Token::Type::Isvoid) {
+      operators_.push_back({.type = next_->type, .line = line, .precedence = kUnaryPrecedence});
+      next_++;
+      position = Position::Operand;
+    } else if (next_->type == Token::Type::LParen) {
+      frames_.push_back({.operators = operators_.size(), .line = line});
+      next_++;
+      position = Position::Expression;
     } else {
-      term = {Sub{line, std::move(lhs), std::move(rhs)}};
+      return;
     }
   }
-  return term;
 }
 
-/// expr (*|/) expr
-Expression Parser::ParseMulDiv() {
-  auto term = ParseIsVoidOrInversion();
-  while (next_->type == Token::Type::Mul || next_->type == Token::Type::Slash) {
-    auto line = next_->line;
-    auto type = next_->type;
-    ++next_;
-    auto next_term = ParseIsVoidOrInversion();
-    auto lhs = std::make_shared<Expression>(std::move(term));
-    auto rhs = std::make_shared<Expression>(std::move(next_term));
-
-    if (type == Token::Type::Mul) {
-      term = {Mul{line, std::move(lhs), std::move(rhs)}};
-    } else {
-      term = {Div{line, std::move(lhs), std::move(rhs)}};
+/// Applies operators above base with at least the given precedence to the operands
+void Parser::Reduce(std::size_t base, int precedence) {
+  while (operators_.size() > base && operators_.back().precedence >= precedence) {
+    auto op = operators_.back();
+    operators_.pop_back();
+    auto* rhs = Make(std::move(operands_.back()));
+    operands_.pop_back();
+    switch (op.type) {
+      case Token::Type::Assign:
+        operands_.push_back({Assign{op.line, op.identifier, rhs}});
+        continue;
+      case Token::Type::Not:
+        operands_.push_back({Not{op.line, rhs}});
+        continue;
+      case Token::Type::Tilde:
+        operands_.push_back({Inversion{op.line, rhs}});
+        continue;
+      case Token::Type::Isvoid:
+        operands_.push_back({IsVoid{op.line, rhs}});
+        continue;
+      default:
+        break;
+    }
+    auto& result = operands_.back();
+    auto* lhs = Make(std::move(result));
+    switch (op.type) {
+      case Token::Type::Plus:
+        result = {Plus{op.line, lhs, rhs}};
+        break;
+      case Token::Type::Minus:
+        result = {Sub{op.line, lhs, rhs}};
+        break;
+      case Token::Type::Mul:
+        result = {Mul{op.line, lhs, rhs}};
+        break;
+      case Token::Type::Slash:
+        result = {Div{op.line, lhs, rhs}};
+        break;
+      case Token::Type::Less:
+        result = {Less{op.line, lhs, rhs}};
+        break;
+      case Token::Type::Leq:
+        result = {LessEq{op.line, lhs, rhs}};
+        break;
+      default:
+        result = {Equal{op.line, lhs, rhs}};
     }
   }
-  return term;
 }
 
-/// (~|isvoid) expr
-Expression Parser::ParseIsVoidOrInversion() {
+/// dispatch with its atom
+bool Parser::ParsePrimary() {
   auto line = next_->line;
-  if (Match(Token::Type::Isvoid)) {
-    return {IsVoid{line, std::make_shared<Expression>(ParseIsVoidOrInversion())}};
-  } else if (Match(Token::Type::Tilde)) {
-    return {Inversion{line, std::make_shared<Expression>(ParseIsVoidOrInversion())}};
+  switch (next_->type) {
+    case Token::Type::ObjectID:
+      if (next_.Peek(1).type == Token::Type::LParen) {
+        Dispatch res;
+        res.line_number = line;
+        res.expr = Make(Id{line, symbols::kSelf});
+        return ParseCall(&res) && ParseDispatchChain(std::move(res));
+      }
+      break;
+    case Token::Type::If:
+    case Token::Type::While:
+    case Token::Type::Let:
+    case Token::Type::Case:
+      compounds_.push_back({.type = next_->type, .line = line});
+      next_++;
+      return Continue(nullptr);
+    case Token::Type::LBrace:
+      compounds_.push_back({.type = next_->type, .line = line});
+      AssertMatch(Token::Type::LBrace);
+      return Continue(nullptr);
+    default:
+      break;
   }
-  return ParseDispatch();
+  return ParseDispatch(ParseAtom(), line);
 }
 
-/// expr[@Type].Id([expr]*)
-Expression Parser::ParseDispatch() {
+/// atom[@Type].Id([expr]*), line is the line of the first token of the atom
+bool Parser::ParseDispatch(Expression atom, std::size_t line) {
   Dispatch res;
+  res.line_number = line;
+  if (Match(Token::Type::At)) {
+    Assert(next_->type == Token::Type::TypeID);
+    res.type_id = *next_->lexeme;
+    next_++;
+    Assert(next_->type == Token::Type::Dot);
+  }
+  if (!Match(Token::Type::Dot)) {
+    operands_.push_back(std::move(atom));
+    return true;
+  }
+  res.expr = Make(std::move(atom));
+  return ParseCall(&res) && ParseDispatchChain(std::move(res));
+}
 
-  auto parse_simple = [&] {
-    res.object_id = std::make_shared<Id>(Id{next_->line, *next_->lexeme});
+/// [.Id([expr]*)]* after a call, static dispatch is allowed only in the first call of a chain
+bool Parser::ParseDispatchChain(Dispatch res) {
+  while (next_->type == Token::Type::Dot) {
+    res.expr = Make(std::move(res));
+    res.type_id.reset();
+    res.line_number = next_->line;
     next_++;
-    res.parameters = GetParameterList();
-  };
-  res.line_number = next_->line;
+    if (!ParseCall(&res)) {
+      return false;
+    }
+  }
+  operands_.push_back({std::move(res)});
+  return true;
+}
 
-  if (next_->type == Token::Type::ObjectID && std::next(next_)->type == Token::Type::LParen) {
-    res.expr = std::make_shared<Expression>(Id{next_->line, "self"});
-    parse_simple();
-  } else {
-    auto a = ParseAtom();
-    if (Match(Token::Type::At)) {
-      Assert(next_->type == Token::Type::TypeID);
-      res.type_id = *next_->lexeme;
+bool Parser::ParseCall(Dispatch* res) {
+  Assert(next_->type == Token::Type::ObjectID);
+  res->object_id = arena_->New<Id>(Id{next_->line, *next_->lexeme});
+  res->parameters = {};
+  next_++;
+  if (!Match(Token::Type::LParen) || Match(Token::Type::RParen)) {
+    return true;
+  }
+  compounds_.push_back({.type = Token::Type::LParen, .line = res->line_number, .call = std::move(*res)});
+  OpenNested();
+  return false;
+}
+
+void Parser::OpenNested() {
+  frames_.push_back({.operators = operators_.size(), .nested = true});
+}
+
+/// Each compound is the loop of its recursive descent: the state is the number of nested expressions parsed so far
+bool Parser::Continue(Expression* nested) {
+  auto& top = compounds_.back();
+  switch (top.type) {
+    case Token::Type::If:
+      if (nested) {
+        top.exprs.push_back(nested);
+      }
+      if (top.exprs.size() == 1) {
+        AssertMatch(Token::Type::Then);
+      } else if (top.exprs.size() == 2) {
+        AssertMatch(Token::Type::Else);
+      } else if (top.exprs.size() == 3) {
+        AssertMatch(Token::Type::Fi);
+        return Complete({If{{top.line}, top.exprs[0], top.exprs[1], top.exprs[2]}});
+      }
+      break;
+    case Token::Type::While:
+      if (nested) {
+        top.exprs.push_back(nested);
+      }
+      if (top.exprs.size() == 1) {
+        AssertMatch(Token::Type::Loop);
+      } else if (top.exprs.size() == 2) {
+        AssertMatch(Token::Type::Pool);
+        return Complete({While{{top.line}, top.exprs[0], top.exprs[1]}});
+      }
+      break;
+    case Token::Type::LBrace:
+      if (nested) {
+        top.exprs.push_back(nested);
+        AssertMatch(Token::Type::Semicolon);
+      }
+      if (next_->type != Token::Type::RBrace) {
+        top.stacks = Stacks();
+        break;
+      }
+      Expect(!top.exprs.empty() || top.recovered);
+      AssertMatch(Token::Type::RBrace);
+      return Complete({Block{{top.line}, arena_->NewArray<Expression*>(top.exprs)}});
+    case Token::Type::Case:
+      if (nested && top.exprs.empty()) {
+        top.exprs.push_back(nested);
+        AssertMatch(Token::Type::Of);
+      } else if (nested) {
+        top.bindings.back().expr = nested;
+        AssertMatch(Token::Type::Semicolon);
+      } else {
+        break;
+      }
+      if (next_->type != Token::Type::Esac) {
+        top.bindings.push_back(ParseBinding());
+        AssertMatch(Token::Type::Darrow);
+        break;
+      }
+      Assert(!top.bindings.empty());
+      AssertMatch(Token::Type::Esac);
+      return Complete({Case{{top.line}, top.exprs[0], arena_->NewArray<Attribute>(top.bindings)}});
+    case Token::Type::Let: {
+      if (top.body) {
+        return Complete({Let{{top.line}, nested, arena_->NewArray<Attribute>(top.bindings)}});
+      }
+      // a binding has been parsed
+      bool binding = nested != nullptr;
+      if (nested) {
+        top.bindings.back().expr = nested;
+      }
+      while (true) {
+        if (binding) {
+          if (next_->type == Token::Type::Comma) {
+            next_++;
+          } else if (next_->type != Token::Type::In) {
+            Assert(false);
+          }
+        }
+        if (next_->type == Token::Type::In) {
+          break;
+        }
+        top.bindings.push_back(ParseBinding());
+        if (Match(Token::Type::Assign)) {
+          OpenNested();
+          return false;
+        }
+        top.bindings.back().expr = Make(Empty{});
+        binding = true;
+      }
+      Assert(!top.bindings.empty());
       next_++;
-      Assert(next_->type == Token::Type::Dot);
+      top.body = true;
+      break;
     }
-    if (Match(Token::Type::Dot)) {
-      res.expr = std::make_shared<Expression>(std::move(a));
-      parse_simple();
-    } else {
-      return a;
+    default: {
+      // arguments of a call
+      top.exprs.push_back(nested);
+      if (Match(Token::Type::Comma)) {
+        Assert(next_->type != Token::Type::RParen);
+      }
+      if (Match(Token::Type::RParen)) {
+        auto res = std::move(top.call);
+        res.parameters = arena_->NewArray<Expression*>(top.exprs);
+        compounds_.pop_back();
+        return ParseDispatchChain(std::move(res));
+      }
+      break;
     }
   }
-  while (next_->type == Token::Type::Dot) {
-    res.expr = std::make_shared<Expression>(std::move(res));
-    res.line_number = next_->line;
-    next_++;
-    parse_simple();
-  }
-  return {std::move(res)};
+  OpenNested();
+  return false;
+}
+
+bool Parser::Complete(Expression atom) {
+  auto line = compounds_.back().line;
+  compounds_.pop_back();
+  return ParseDispatch(std::move(atom), line);
 }
 
 Expression Parser::ParseAtom() {
   auto line = next_->line;
   if (next_->type == Token::Type::Integer) {
-    int32_t value = std::stoi(*(next_++)->lexeme);
+    int32_t value = std::stoi((next_++).lexeme->Str());
     return {Int{line, value}};
   }
   if (next_->type == Token::Type::String) {
-    return {String{line, *(next_++)->lexeme}};
+    return {String{line, *(next_++).lexeme}};
   }
   if (next_->type == Token::Type::True || next_->type == Token::Type::False) {
-    return {Bool{line, (next_++)->type == Token::Type::True}};
-  }
-  if (next_->type == Token::Type::If) {
-    return ParseIf();
-  }
-  if (next_->type == Token::Type::While) {
-    return ParseWhile();
-  }
-  if (next_->type == Token::Type::LBrace) {
-    return ParseBlock();
+    return {Bool{line, (next_++).type == Token::Type::True}};
   }
   if (next_->type == Token::Type::New) {
     return ParseNew();
   }
-  if (next_->type == Token::Type::Case) {
-    return ParseCase();
-  }
-  if (Match(Token::Type::LParen)) {
-    auto exp = ParseExpression();
-    Assert(next_->type == Token::Type::RParen);
-    next_++;
-    return exp;
-  }
   if (next_->type == Token::Type::ObjectID) {
     Id res{{line}, *next_->lexeme};
     ++next_;
     return {std::move(res)};
   }
-  if (next_->type == Token::Type::Let) {
-    Let res;
-    res.line_number = line;
-    next_++;
-    while (next_->type != Token::Type::In) {
-      res.attrs.push_back(ParseAttributeFeature());
-      if (next_->type == Token::Type::Comma) {
-        next_++;
-      } else if (next_->type != Token::Type::In) {
-        Assert(false);
-      }
-    }
-    Assert(res.attrs.size() > 0 && next_->type == Token::Type::In);
-    next_++;
-    res.expr = std::make_shared<Expression>(ParseExpression());
-    return {std::move(res)};
-  }
   Assert(false);
   // only for avoid warnings that function is noreturn
   return {Empty{}};
 }
 
-Expression Parser::ParseExpression() {
-  return ParseAssign();
-}
-
-Expression Parser::ParseIf() {
-  Assert(next_->type == Token::Type::If);
-  If res;
-  res.line_number = (next_++)->line;
-  res.condition = std::make_shared<Expression>(ParseExpression());
-  AssertMatch(Token::Type::Then);
-  res.then_expr = std::make_shared<Expression>(ParseExpression());
-  AssertMatch(Token::Type::Else);
-  res.else_expr = std::make_shared<Expression>(ParseExpression());
-  AssertMatch(Token::Type::Fi);
-  return {std::move(res)};
-}
-
-Expression Parser::ParseWhile() {
-  Assert(next_->type == Token::Type::While);
-  While res;
-  res.line_number = (next_++)->line;
-  res.condition = std::make_shared<Expression>(ParseExpression());
-  AssertMatch(Token::Type::Loop);
-  res.loop_body = std::make_shared<Expression>(ParseExpression());
-  AssertMatch(Token::Type::Pool);
+Expression Parser::ParseNew() {
+  Assert(next_->type == Token::Type::New);
+  auto line = (next_++).line;
+  Assert(next_->type == Token::Type::TypeID);
+  New res{line, *(next_++).lexeme};
   return {std::move(res)};
 }
 
-Expression Parser::ParseBlock() {
-  Assert(next_->type == Token::Type::LBrace);
-  Block res;
-  res.line_number = (next_++)->line;
-  while (next_->type != Token::Type::RBrace) {
-    auto expr = ParseExpression();
-    res.expr.push_back(std::make_shared<Expression>(std::move(expr)));
-    AssertMatch(Token::Type::Semicolon);
-  }
-  Assert(res.expr.size() > 0);
-  AssertMatch(Token::Type::RBrace);
-  return {std::move(res)};
+Expression* Parser::Make(Expression expr) {
+  return arena_->New<Expression>(std::move(expr));
 }
 
-Expression Parser::ParseCase() {
-  Assert(next_->type == Token::Type::Case);
-  Case res;
-  res.line_number = next_->line;
-  next_++;
-  res.expr = std::make_shared<Expression>(ParseExpression());
-  AssertMatch(Token::Type::Of);
-
-  while (next_->type != Token::Type::Esac) {
-    Assert(next_->type == Token::Type::ObjectID);
-    Attribute attr;
-    attr.line_number = next_->line;
-    attr.object_id = *next_->lexeme;
-    next_++;
-    AssertMatch(Token::Type::Colon);
-    Assert(next_->type == Token::Type::TypeID);
-    attr.type_id = *next_->lexeme;
+bool Parser::Match(Token::Type type) {
+  if (next_->type == type) {
     next_++;
-    AssertMatch(Token::Type::Darrow);
-    attr.expr = std::make_shared<Expression>(ParseExpression());
-    AssertMatch(Token::Type::Semicolon);
-    res.cases.push_back(std::move(attr));
+    return true;
   }
-
-  Assert(res.cases.size() > 0);
-  AssertMatch(Token::Type::Esac);
-  return {std::move(res)};
+  return false;
 }
 
-Expression Parser::ParseNew() {
-  Assert(next_->type == Token::Type::New);
-  auto line = (next_++)->line;
-  Assert(next_->type == Token::Type::TypeID);
-  New res{line, *(next_++)->lexeme};
-  return {std::move(res)};
+Parser::StackSizes Parser::Stacks() const {
+  return {.operands = operands_.size(),
+          .operators = operators_.size(),
+          .frames = frames_.size(),
+          .compounds = compounds_.size(),
+          .braces = braces_};
 }
 
-std::vector<std::shared_ptr<Expression>> Parser::GetParameterList() {
-  std::vector<std::shared_ptr<Expression>> parameters;
-  if (Match(Token::Type::LParen)) {
-    while (!Match(Token::Type::RParen)) {
-      parameters.emplace_back(std::make_shared<Expression>(ParseExpression()));
-      if (Match(Token::Type::Comma)) {
-        Assert(next_->type != Token::Type::RParen);
+bool Parser::Synchronize(const StackSizes& stacks) {
+  if (mode_ != ErrorMode::Recover) {
+    return false;
+  }
+  operands_.erase(operands_.begin() + static_cast<std::ptrdiff_t>(stacks.operands), operands_.end());
+  operators_.erase(operators_.begin() + static_cast<std::ptrdiff_t>(stacks.operators), operators_.end());
+  frames_.erase(frames_.begin() + static_cast<std::ptrdiff_t>(stacks.frames), frames_.end());
+  compounds_.erase(compounds_.begin() + static_cast<std::ptrdiff_t>(stacks.compounds), compounds_.end());
+  auto depth = braces_ - stacks.braces;
+  braces_ = stacks.braces;
+  for (; next_->type != Token::Type::Class && !IsEnd(*next_); ++next_) {
+    if (next_->type == Token::Type::LBrace) {
+      ++depth;
+    } else if (next_->type == Token::Type::RBrace) {
+      if (depth == 0) {
+        Recovered(false);
+        return true;
       }
+      --depth;
+    } else if (next_->type == Token::Type::Semicolon) {
+      ++next_;
+      Recovered(true);
+      return true;
     }
   }
-  return parameters;
+  // a class keyword starts a new class, as it does for a chunk of the parallel mode, so its errors are reported
+  quiet_until_ = Index();
+  return false;
 }
 
-bool Parser::Match(Token::Type type) {
-  if (next_->type == type) {
-    next_++;
-    return true;
+void Parser::SynchronizeClass() {
+  Synchronize({});
+  // a '}' closing braces opened before the error is skipped with the tokens after it
+  while (next_->type == Token::Type::RBrace) {
+    ++next_;
+    Synchronize({});
   }
-  return false;
+}
+
+void Parser::Recovered(bool semicolon) {
+  quiet_until_ = Index() + kRecoveredTokens - (semicolon ? 1 : 0);
 }
 
 void Parser::Assert(bool condition) {
   if (!condition) {
-    std::cerr << filename_ << ", line " << next_->line << std::endl
-              << "Compilation halted due to lex and parse errors" << std::endl;
-    std::exit(1);
+    Error();
+    throw SyntaxError{ErrorLine()};
   }
 }
 
+void Parser::Expect(bool condition) {
+  if (!condition) {
+    Error();
+  }
+}
+
+void Parser::Error() {
+  if (mode_ == ErrorMode::Recover) {
+    if (Index() >= quiet_until_) {
+      diagnostics_.push_back({.line = ErrorLine(), .near = Near(*next_)});
+    }
+    return;
+  }
+  if (throw_errors_) {
+    throw SyntaxError{ErrorLine()};
+  }
+  Fail(ErrorLine());
+}
+
+std::size_t Parser::ErrorLine() const {
+  return IsEnd(*next_) ? next_.PreviousLine() : next_->line;
+}
+
+void Parser::PrintDiagnostics(std::ostream& out) const {
+  for (const auto& diagnostic : diagnostics_) {
+    out << '"' << filename_ << "\", line " << diagnostic.line << ": syntax error at or near " << diagnostic.near
+        << std::endl;
+  }
+}
+
+void Parser::Fail(std::size_t line) const {
+  std::cerr << filename_ << ", line " << line << std::endl
+            << "Compilation halted due to lex and parse errors" << std::endl;
+  std::exit(1);
+}
+
 void Parser::AssertMatch(Token::Type type) {
   if (next_->type != type) {
     Assert(false);
   }
+  if (type == Token::Type::LBrace) {
+    ++braces_;
+  } else if (type == Token::Type::RBrace) {
+    --braces_;
+  }
   next_++;
 }
 
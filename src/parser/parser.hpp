@@ -2,9 +2,16 @@
 
 #include "ast/expression.hpp"
 #include "token/token.hpp"
+#include "token/token_buffer.hpp"
+#include "token/token_stream.hpp"
+#include "util/arena.hpp"
+#include "util/thread_pool.hpp"
 
 #include <cassert>
+#include <limits>
 #include <memory>
+#include <ostream>
+#include <span>
 #include <variant>
 #include <vector>
 
@@ -12,39 +19,219 @@ namespace coolc {
 
 class Parser {
  public:
-  explicit Parser(const std::vector<coolc::Token>& tokens, std::string filename);
+  enum class ErrorMode {
+    /// the first syntax error is printed and terminates the process
+    Halt,
+    /// Panic mode: errors are collected into Diagnostics() and parsing resumes at the next ';', '}' or class
+    /// keyword, ParseProgram() returns the classes and features parsed without errors
+    Recover,
+  };
+
+  /// syntax error at a token
+  struct Diagnostic {
+    std::size_t line;
+    /// the token as the reference parser prints it: OBJECTID = x, ';', EOF
+    std::string near;
+  };
+
+  /// tokens must outlive the parser
+  explicit Parser(const TokenBuffer& tokens, std::string filename, ErrorMode mode = ErrorMode::Halt);
+
+  /// Streaming mode: tokens are pulled while parsing, only the lookahead is kept in memory
+  explicit Parser(TokenStream tokens, std::string filename, ErrorMode mode = ErrorMode::Halt);
 
   Program ParseProgram();
 
+  static constexpr std::size_t kMinParallelClasses = 64;
+
+  /// Same program as ParseProgram(), classes are parsed by chunks on the pool. Only for a parser over a TokenBuffer
+  /// which has not started parsing, otherwise parses serially.
+  /// Chunks start at class keywords outside of braces. They are merged in order while every chunk starts where the
+  /// previous one has ended and in the state a chunk starts with: no errors kept quiet after a recovery and no braces
+  /// open. The rest is parsed serially. A chunk stops at its first error, so the reported error is
+  /// the first one in source order, as in ParseProgram().
+  Program ParseProgram(util::ThreadPool& pool, std::size_t min_classes = kMinParallelClasses);
+
+  /// Incremental mode of a parser over a TokenBuffer which has parsed previous and whose tokens have been changed
+  /// since, e.g. by Lexer::Relex. Classes and features of previous which were parsed without errors and do not
+  /// overlap the changed tokens are moved to the result with their lines shifted, the rest is parsed again.
+  /// Expressions stay in the arena of previous, so the replaced subtrees are freed only with the program.
+  Program Reparse(Program previous, const TokenBuffer::Change& change);
+
+  /// syntax errors in source order, only in the Recover mode
+  const std::vector<Diagnostic>& Diagnostics() const {
+    return diagnostics_;
+  }
+
+  /// one line per diagnostic: "file", line 3: syntax error at or near OBJECTID = x
+  void PrintDiagnostics(std::ostream& out) const;
+
  private:
+  struct Chunk;
+
+  static constexpr std::size_t kNoEnd = std::numeric_limits<std::size_t>::max();
+  static constexpr std::size_t kRecoveredTokens = 3;
+
+  /// Thrown by Assert unless the process is terminated, the error is already recorded.
+  /// Caught where the panic mode synchronizes and by the chunks of the parallel mode.
+  struct SyntaxError {
+    std::size_t line;
+  };
+
+  /// tokens [begin, end) of a class or a feature with its ';', clean if it was parsed without errors
+  struct Span {
+    std::size_t begin;
+    std::size_t end;
+    bool clean;
+  };
+
+  /// class of the previous program and the spans of its features, offset moves its spans to the new tokens
+  struct ReusableClass {
+    Span span;
+    Class* node;
+    std::span<const Span> features;
+    std::ptrdiff_t offset;
+  };
+
+  struct ReusableFeature {
+    Span span;
+    Feature* node;
+  };
+
+  /// sizes of the expression stacks and the number of open braces, restored when an error is recovered
+  struct StackSizes {
+    std::size_t operands;
+    std::size_t operators;
+    std::size_t frames;
+    std::size_t compounds;
+    std::size_t braces;
+  };
+
+  static Chunk ParseChunk(const TokenBuffer& tokens, const std::string& filename, ErrorMode mode,
+                          std::size_t begin, std::size_t end);
+
+  /// classes starting at the current token, then the end of file
+  void ParseClasses(Program* res);
+  /// classes until the end of file or the first class starting at or after the token at end
+  void ParseClassList(std::vector<Class>* classes, std::size_t end);
+
+  /// index of the current token in the buffer
+  std::size_t Index() const {
+    return first_ + next_.Consumed();
+  }
+
+  /// moves the stream to the token at index of the buffer
+  void Seek(std::size_t index);
+
+  /// Reusable item of Reparse which starts at the token at index.
+  /// Items are sorted by their start, next is the first one which may be still ahead.
+  template <typename T>
+  T* TakeReusable(std::vector<T>* items, std::size_t* next, std::size_t index);
+
+  StackSizes Stacks() const;
+
+  /// Panic mode inside braces: restores the stacks and skips tokens to the next ';' (consumed), as the error rules of
+  /// the reference parser do, or to a '}' outside of the braces opened since the stacks were saved. False if a class
+  /// keyword or the end of file comes first or the mode is not Recover, then the error is left to the enclosing list.
+  bool Synchronize(const StackSizes& stacks);
+
+  /// Panic mode between classes: skips tokens to the next ';' (consumed) or class keyword
+  void SynchronizeClass();
+
+  /// errors are not reported until kRecoveredTokens tokens are consumed after a recovery, counting its ';'
+  void Recovered(bool semicolon);
   Class ParseClass();
-  std::optional<Feature> ParseFeature();
+  Feature ParseFeature();
   Attribute ParseAttributeFeature();
   Method ParseMethodFeature();
   std::optional<Formal> ParseFormal();
+  /// Id : Type of an attribute, a let binding or a case branch, without its expression
+  Attribute ParseBinding();
   Expression ParseExpression();
 
-  /// Sorted by priority from lowest to highest
-  Expression ParseAssign();
-  Expression ParseNot();
-  Expression ParseComparisons();
-  Expression ParseAddSub();
-  Expression ParseMulDiv();
-  Expression ParseIsVoidOrInversion();
-  Expression ParseDispatch();
-  Expression ParseAtom();
+  /// what may start at the current position of an expression
+  enum class Position {
+    Expression,  // anything
+    Not,         // after not: anything but assignment
+    Operand,     // after binary or unary operator: only unary operators and primary expressions
+  };
+
+  /// pending operator of ParseExpression, identifier is the left side of an assignment
+  struct Operator {
+    Token::Type type;
+    std::size_t line;
+    Symbol identifier{};
+    int precedence{0};
+  };
+
+  /// Expression in progress, its operators are above the operators index: the expression of ParseExpression, a
+  /// parenthesized one or, if nested, an expression of the compound on top
+  struct Frame {
+    std::size_t operators;
+    std::size_t line{0};
+    bool has_comparison{false};
+    bool nested{false};
+  };
+
+  /// If, while, let, case, block or call with arguments whose nested expressions are being parsed, type is its first
+  /// token or '(' for a call. Nested expressions are collected in exprs, but the expressions of let bindings and case
+  /// branches go to their bindings.
+  struct Compound {
+    Token::Type type;
+    std::size_t line;
+    std::vector<Expression*> exprs{};
+    std::vector<Attribute> bindings{};
+    /// call without its arguments
+    Dispatch call{};
+    /// block: stacks before its current expression, restored when an error in it is recovered
+    StackSizes stacks{};
+    bool recovered{false};
+    /// let: the bindings are done, the nested expression is the body
+    bool body{false};
+  };
 
-  Expression ParseIf();
-  Expression ParseWhile();
-  Expression ParseCase();
-  Expression ParseBlock();
+  /// runs the stacks until the frame above frames_base has its value, resume goes on with the block on top of the
+  /// compounds after a recovered error
+  Expression ParseFrames(std::size_t frames_base, bool resume);
+  void ParsePrefixes(Position position);
+  void Reduce(std::size_t base, int precedence);
+
+  /// The next functions parse a primary expression onto the operands and return true, or return false when they have
+  /// opened a nested expression of a compound. The compound goes on with Continue when it ends.
+  bool ParsePrimary();
+  bool ParseDispatch(Expression atom, std::size_t line);
+  bool ParseDispatchChain(Dispatch res);
+  /// takes the nested expression which has ended, if any, and opens the next one or completes the compound on top
+  bool Continue(Expression* nested);
+  /// the compound on top as the atom of a dispatch
+  bool Complete(Expression atom);
+
+  /// Id([expr]*) after the dot, false if the call waits for its arguments on the compounds
+  bool ParseCall(Dispatch* res);
+  void OpenNested();
+  Expression ParseAtom();
   Expression ParseNew();
 
-  std::vector<std::shared_ptr<Expression>> GetParameterList();
+  /// moves the node to the arena of the program
+  Expression* Make(Expression expr);
 
-  /// FillAndCheck condition. If false terminate program with error in stderr
+  /// FillAndCheck condition. If false terminate program with error in stderr or, in the Recover mode, record it and
+  /// throw SyntaxError
   void Assert(bool condition);
 
+  /// Same as Assert, but in the Recover mode the error is only recorded and parsing goes on
+  void Expect(bool condition);
+
+  /// records the error at the current token, terminates the process in the Halt mode
+  void Error();
+
+  /// line of the error at the current token: the end of file is reported at the line of the last token before it,
+  /// or 0 if there is none, as the reference parser does
+  std::size_t ErrorLine() const;
+
+  /// terminates program with error at the line in stderr
+  [[noreturn]] void Fail(std::size_t line) const;
+
   /// FillAndCheck current token type.
   /// If true move next_, otherwise terminate program with error in stderr
   void AssertMatch(Token::Type);
@@ -54,7 +241,34 @@ class Parser {
   bool Match(Token::Type);
 
   std::string filename_;
-  std::vector<coolc::Token>::const_iterator next_;
+  TokenStream next_;
+  util::Arena* arena_{nullptr};
+  /// buffer of next_, if the parser was constructed from one, and index of the first token of next_ in it
+  const TokenBuffer* tokens_{nullptr};
+  std::size_t first_{0};
+  ErrorMode mode_;
+  /// errors are thrown instead of terminating in the Halt mode, set in the chunks of the parallel mode
+  bool throw_errors_{false};
+  std::vector<Diagnostic> diagnostics_;
+  /// errors at the tokens before this index are not reported, they cascade from the last recovered one
+  std::size_t quiet_until_{0};
+  /// braces matched by AssertMatch and not closed yet
+  std::size_t braces_{0};
+
+  /// spans of the classes of the last parsed program and of their features in order
+  std::vector<Span> class_spans_;
+  std::vector<Span> feature_spans_;
+  /// subtrees of the previous program during Reparse
+  std::vector<ReusableClass> reusable_classes_;
+  std::vector<ReusableFeature> reusable_features_;
+  std::size_t next_reusable_class_{0};
+  std::size_t next_reusable_feature_{0};
+
+  /// stacks of ParseExpression
+  std::vector<Expression> operands_;
+  std::vector<Operator> operators_;
+  std::vector<Frame> frames_;
+  std::vector<Compound> compounds_;
 };
 
 }  // namespace coolc
@@ -0,0 +1,173 @@
+#include "semant/class_layout.hpp"
+
+#include "ast/expression.hpp"
+#include "util/type_traits.hpp"
+
+#include <iostream>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace coolc {
+
+template <typename Slot>
+void ClassLayouts::Table<Slot>::Reset(std::size_t classes) {
+  _declarations.clear();
+  _index.clear();
+  _counts.assign(classes, 0);
+  _declared.assign(classes, {0, 0});
+}
+
+template <typename Slot>
+void ClassLayouts::Table<Slot>::Begin(ClassId cl, ClassId parent) {
+  auto size = static_cast<std::uint32_t>(_declarations.size());
+  _counts[cl] = parent == InheritanceGraph::kNoClass ? 0 : _counts[parent];
+  _declared[cl] = {size, size};
+}
+
+template <typename Slot>
+const Slot* ClassLayouts::Table<Slot>::Find(ClassId cl, Symbol name) const {
+  auto it = _index.find(name);
+  if (cl == InheritanceGraph::kNoClass || it == _index.end()) {
+    return nullptr;
+  }
+  auto range = it->second.upper_bound(cl);
+  if (range == it->second.begin() || std::prev(range)->second == kNotDeclared) {
+    return nullptr;
+  }
+  return &_declarations[std::prev(range)->second];
+}
+
+template <typename Slot>
+void ClassLayouts::Table<Slot>::Declare(const InheritanceGraph& ig, ClassId cl, Slot slot, const Slot* inherited) {
+  slot.slot = inherited ? inherited->slot : _counts[cl]++;
+  // the subtree of the class has no declarations yet as classes are laid out parents first, so it is inside one range
+  auto& ranges = _index[slot.name];
+  auto range = ranges.upper_bound(cl);
+  auto enclosing = range == ranges.begin() ? kNotDeclared : std::prev(range)->second;
+  ranges.emplace(ig.Last(cl) + 1, enclosing);
+  ranges[cl] = static_cast<std::uint32_t>(_declarations.size());
+  _declarations.push_back(std::move(slot));
+  ++_declared[cl].second;
+}
+
+template <typename Slot>
+std::vector<const Slot*> ClassLayouts::Table<Slot>::Collect(const InheritanceGraph& ig, ClassId cl) const {
+  std::vector<const Slot*> result(_counts[cl], nullptr);
+  // the deepest declaration of a slot is the one seen by the class
+  for (auto curr = cl; curr != InheritanceGraph::kNoClass; curr = ig.Parent(curr)) {
+    for (auto i = _declared[curr].first; i < _declared[curr].second; ++i) {
+      auto& slot = result[_declarations[i].slot];
+      if (!slot) {
+        slot = &_declarations[i];
+      }
+    }
+  }
+  return result;
+}
+
+const MethodSlot* ClassLayouts::FindMethod(Symbol class_name, Symbol name) const {
+  return _methods.Find(_ig.Id(class_name), name);
+}
+
+const AttributeSlot* ClassLayouts::FindAttribute(Symbol class_name, Symbol name) const {
+  return _attributes.Find(_ig.Id(class_name), name);
+}
+
+std::vector<const MethodSlot*> ClassLayouts::Methods(Symbol class_name) const {
+  return _methods.Collect(_ig, _ig.Id(class_name));
+}
+
+std::vector<const AttributeSlot*> ClassLayouts::Attributes(Symbol class_name) const {
+  return _attributes.Collect(_ig, _ig.Id(class_name));
+}
+
+bool ClassLayouts::Build(const Program& p) {
+  using namespace symbols;
+  auto size = _ig.Size();
+  _methods.Reset(size);
+  _attributes.Reset(size);
+  _done.assign(size, false);
+
+  // the declarations of a class follow its beginning, so a basic class gets its methods before the next one begins
+  LayOut(_ig.Id(kObject), nullptr);
+  AddMethod(_ig.Id(kObject), kAbort, {.return_type = kObject, .args_types = {}});
+  AddMethod(_ig.Id(kObject), kTypeName, {.return_type = kString, .args_types = {}});
+  AddMethod(_ig.Id(kObject), kCopy, {.return_type = kSelfType, .args_types = {}});
+  LayOut(_ig.Id(kIO), nullptr);
+  AddMethod(_ig.Id(kIO), kOutString, {.return_type = kSelfType, .args_types = {kString}});
+  AddMethod(_ig.Id(kIO), kInString, {.return_type = kString, .args_types = {}});
+  AddMethod(_ig.Id(kIO), kOutInt, {.return_type = kSelfType, .args_types = {kInt}});
+  AddMethod(_ig.Id(kIO), kInInt, {.return_type = kInt, .args_types = {}});
+  LayOut(_ig.Id(kString), nullptr);
+  AddMethod(_ig.Id(kString), kLength, {.return_type = kInt, .args_types = {}});
+  AddMethod(_ig.Id(kString), kSubstr, {.return_type = kString, .args_types = {kInt, kInt}});
+  AddMethod(_ig.Id(kString), kConcat, {.return_type = kString, .args_types = {kString}});
+  LayOut(_ig.Id(kInt), nullptr);
+  LayOut(_ig.Id(kBool), nullptr);
+
+  std::vector<const Class*> definitions(size, nullptr);
+  for (const auto& cl : p.classes) {
+    definitions[_ig.Id(cl.type)] = &cl;
+  }
+  // classes are taken in the order of the program, the missing ancestors of a class are laid out before it
+  std::vector<ClassId> pending;
+  for (const auto& cl : p.classes) {
+    for (auto curr = _ig.Id(cl.type); !_done[curr]; curr = _ig.Parent(curr)) {
+      pending.push_back(curr);
+    }
+    for (; !pending.empty(); pending.pop_back()) {
+      CHECK_ERROR(LayOut(pending.back(), definitions[pending.back()]))
+    }
+  }
+  return true;
+}
+
+void ClassLayouts::AddMethod(ClassId id, Symbol name, MethodTypes types) {
+  _methods.Declare(_ig, id, {name, _ig.Name(id), 0, std::move(types)}, nullptr);
+}
+
+bool ClassLayouts::LayOut(ClassId id, const Class* cl) {
+  auto name = _ig.Name(id);
+  _methods.Begin(id, _ig.Parent(id));
+  _attributes.Begin(id, _ig.Parent(id));
+  _done[id] = true;
+  if (!cl) {
+    return true;
+  }
+  for (const auto& f : cl->features) {
+    bool ok = std::visit(
+        util::Overloaded{[&](const Attribute& a) {
+                           CHECK_ERROR(a.object_id != symbols::kSelf)
+                           CHECK_ERROR(!_attributes.Find(id, a.object_id))
+                           _attributes.Declare(_ig, id, {a.object_id, name, 0, a.type_id}, nullptr);
+                           return true;
+                         },
+                         [&](const Method& m) {
+                           const auto* inherited = _methods.Find(id, m.object_id);
+                           // defined twice in the class
+                           CHECK_ERROR(!inherited || inherited->owner != name)
+                           MethodTypes types{m.type_id, {}};
+                           for (const auto& el : m.formals) {
+                             types.args_types.emplace_back(el.type_id);
+                           }
+                           if (inherited && inherited->types != types) {
+                             if (inherited->types.args_types.size() != types.args_types.size()) {
+                               std::cerr << "Incompatible number of formal parameters in redefined method "
+                                         << m.object_id << std::endl;
+                             } else if (inherited->types.return_type != types.return_type) {
+                               std::cerr << "Incompatible return types in redefined method " << m.object_id
+                                         << std::endl;
+                             }
+                             return false;
+                           }
+                           _methods.Declare(_ig, id, {m.object_id, name, 0, std::move(types)}, inherited);
+                           return true;
+                         }},
+        f.feature);
+    CHECK_ERROR(ok)
+  }
+  return true;
+}
+
+}  // namespace coolc
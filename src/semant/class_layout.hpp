@@ -0,0 +1,106 @@
+#pragma once
+
+#include "ast/expression.hpp"
+#include "semant/inheritance_graph.hpp"
+#include "symbol/symbol.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace coolc {
+
+struct MethodTypes {
+  Symbol return_type;
+  std::vector<Symbol> args_types;
+  friend bool operator==(const MethodTypes& lhs, const MethodTypes& rhs) {
+    return (lhs.return_type == rhs.return_type) && (lhs.args_types == rhs.args_types);
+  }
+
+  friend bool operator!=(const MethodTypes& lhs, const MethodTypes& rhs) {
+    return !(lhs == rhs);
+  }
+};
+
+/// A method as declared in its class. slot is its index in the dispatch tables of the class and all its subclasses,
+/// an overriding method has the slot of the overridden one.
+struct MethodSlot {
+  Symbol name;
+  Symbol owner;
+  std::uint32_t slot;
+  MethodTypes types;
+};
+
+/// An attribute as declared in its class, slot is its index in the objects of the class and all its subclasses
+struct AttributeSlot {
+  Symbol name;
+  Symbol owner;
+  std::uint32_t slot;
+  Symbol type;
+};
+
+/// Dispatch tables and object layouts of the basic classes and the classes of a program.
+/// A class lays out the slots of its parent first and in the same order and appends the slots of its new features.
+/// Only declarations are stored, so memory is linear in the size of the program whatever the depth of the hierarchy.
+/// The class ids of the InheritanceGraph are DFS pre-order, so a subtree is a range of ids. A name maps to the ranges
+/// of ids where each declaration is seen: a declaration covers the subtree of its class except the subtrees of the
+/// declarations below it. A lookup is a hash probe and a binary search among the few ranges of the name.
+class ClassLayouts {
+ public:
+  explicit ClassLayouts(const InheritanceGraph& ig) : _ig(ig) {
+  }
+
+  /// Lays out every class after its parent and checks redefinitions of features on the way, stops at the first error.
+  /// pre-condition: FillAndCheck of the graph succeeded for the program
+  bool Build(const Program& p);
+
+  /// the method called on objects of the class, nullptr if the class is not defined or has no such method
+  const MethodSlot* FindMethod(Symbol class_name, Symbol name) const;
+  const AttributeSlot* FindAttribute(Symbol class_name, Symbol name) const;
+
+  /// Dispatch table of the class, the element i is the method in the slot i. Built on request from the declarations.
+  /// pre-condition: the class is defined
+  std::vector<const MethodSlot*> Methods(Symbol class_name) const;
+  /// Attributes of objects of the class by slot
+  std::vector<const AttributeSlot*> Attributes(Symbol class_name) const;
+
+ private:
+  using ClassId = InheritanceGraph::ClassId;
+
+  /// declarations of one kind of features
+  template <typename Slot>
+  class Table {
+   public:
+    void Reset(std::size_t classes);
+    /// starts the declarations of the class, pre-condition: its parent is done
+    void Begin(ClassId cl, ClassId parent);
+    /// the declaration seen by the class, its own or an inherited one
+    const Slot* Find(ClassId cl, Symbol name) const;
+    /// declares a feature of the class which has begun last, inherited is what Find returns for it before
+    void Declare(const InheritanceGraph& ig, ClassId cl, Slot slot, const Slot* inherited);
+    std::vector<const Slot*> Collect(const InheritanceGraph& ig, ClassId cl) const;
+
+   private:
+    static constexpr std::uint32_t kNotDeclared = std::numeric_limits<std::uint32_t>::max();
+
+    std::vector<Slot> _declarations;
+    /// by name: the first id of each range and the declaration seen in it up to the next range
+    std::unordered_map<Symbol, std::map<ClassId, std::uint32_t>> _index;
+    /// by class: the number of slots and the range of its own declarations
+    std::vector<std::uint32_t> _counts;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> _declared;
+  };
+
+  bool LayOut(ClassId id, const Class* cl);
+  void AddMethod(ClassId id, Symbol name, MethodTypes types);
+
+  const InheritanceGraph& _ig;
+  Table<MethodSlot> _methods;
+  Table<AttributeSlot> _attributes;
+  std::vector<bool> _done;
+};
+
+}  // namespace coolc
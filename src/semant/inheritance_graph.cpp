@@ -2,18 +2,24 @@
 
 #include "ast/expression.hpp"
 
+#include <algorithm>
+#include <bit>
 #include <cassert>
+#include <cstdint>
 #include <deque>
-#include <functional>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace coolc {
 
 InheritanceGraph::InheritanceGraph() {
-  _classes_graph = {
-      {"Object", "Object"}, {"Int", "Object"}, {"String", "Object"}, {"Bool", "Object"}, {"IO", "Object"}};
+  _classes_graph = {{symbols::kObject, symbols::kObject},
+                    {symbols::kInt, symbols::kObject},
+                    {symbols::kString, symbols::kObject},
+                    {symbols::kBool, symbols::kObject},
+                    {symbols::kIO, symbols::kObject}};
 }
 
 void InheritanceGraph::Reserve(std::size_t size) {
@@ -21,25 +27,25 @@ void InheritanceGraph::Reserve(std::size_t size) {
 }
 
 bool InheritanceGraph::InsertClass(const Class& cl) {
-  static constexpr std::array fund = {"Int", "String", "Bool"};
+  static constexpr std::array fund = {symbols::kInt, symbols::kString, symbols::kBool};
 
-  if (cl.type == "SELF_TYPE") {
+  if (cl.type == symbols::kSelfType) {
     std::cerr << MakeError(cl, "Redefinition of basic class SELF_TYPE.");
     return false;
   }
 
   if (IsBasic(cl.type)) {
-    std::cerr << MakeError(cl, "Redefinition of basic class " + cl.type + ".");
+    std::cerr << MakeError(cl, "Redefinition of basic class " + cl.type.Str() + ".");
     return false;
   }
 
   if (std::find(fund.begin(), fund.end(), cl.inherits_type) != fund.end()) {
-    std::cerr << MakeError(cl, "Class " + cl.type + " cannot inherit class " + cl.inherits_type);
+    std::cerr << MakeError(cl, "Class " + cl.type.Str() + " cannot inherit class " + cl.inherits_type.Str());
     return false;
   }
 
   if (_classes_graph.contains(cl.type)) {
-    std::cerr << MakeError(cl, "Class " + cl.type + " was previously defined.");
+    std::cerr << MakeError(cl, "Class " + cl.type.Str() + " was previously defined.");
     return false;
   }
   _classes_graph[cl.type] = cl.inherits_type;
@@ -48,7 +54,8 @@ bool InheritanceGraph::InsertClass(const Class& cl) {
 
 bool InheritanceGraph::CheckAncessorDefined(const Class& cl) const {
   if (!_classes_graph.contains(cl.inherits_type)) {
-    std::cerr << MakeError(cl, "Class " + cl.type + " inherits from undefined class " + cl.inherits_type + ".");
+    std::cerr << MakeError(cl,
+                           "Class " + cl.type.Str() + " inherits from undefined class " + cl.inherits_type.Str() + ".");
     return false;
   }
   return true;
@@ -56,27 +63,44 @@ bool InheritanceGraph::CheckAncessorDefined(const Class& cl) const {
 
 // pre-condition: all base classes must be in classes graph as keys
 bool InheritanceGraph::CheckAcyclic() const {
-  std::unordered_map<std::string_view, bool> visited(_classes_graph.size());
-  std::function<bool(std::string_view)> dfs;
+  // dense ids in the iteration order of the graph, errors are reported in this order
+  std::vector<Symbol> names;
+  names.reserve(_classes_graph.size());
+  std::uint32_t max_symbol = 0;
+  for (const auto& el : _classes_graph) {
+    names.push_back(el.first);
+    max_symbol = std::max(max_symbol, el.first.Id());
+  }
+  std::vector<std::uint32_t> ids(max_symbol + 1);
+  for (std::uint32_t i = 0; i < names.size(); ++i) {
+    ids[names[i].Id()] = i;
+  }
 
-  // returns true if connectivity component is acyclic
-  dfs = [&](std::string_view v) {
-    if (visited[v]) {
-      return false;
+  // a class is cyclic if its chain of parents never reaches Object. Each walk goes up through unvisited classes,
+  // marking them grey, and stops at a coloured one: a grey class closes a cycle on the walk, otherwise the walk
+  // gets the colour of the class where it stopped. So every class is walked over once.
+  enum class Colour : std::uint8_t { White, Grey, Acyclic, Cyclic };
+  std::vector<Colour> colours(names.size(), Colour::White);
+  colours[ids[symbols::kObject.Id()]] = Colour::Acyclic;
+  std::vector<std::uint32_t> path;
+  for (std::uint32_t start = 0; start < names.size(); ++start) {
+    auto v = start;
+    while (colours[v] == Colour::White) {
+      colours[v] = Colour::Grey;
+      path.push_back(v);
+      v = ids[_classes_graph.at(names[v]).Id()];
     }
-    visited[v] = true;
-    bool is_acyclic = true;
-    if (_classes_graph.at(std::string{v}) != "Object") {
-      is_acyclic = dfs(_classes_graph.at(std::string{v}));
+    auto colour = colours[v] == Colour::Acyclic ? Colour::Acyclic : Colour::Cyclic;
+    for (auto u : path) {
+      colours[u] = colour;
     }
-    visited[v] = false;
-    return is_acyclic;
-  };
+    path.clear();
+  }
 
   bool is_acyclic = true;
-  for (const auto& el : _classes_graph) {
-    if (!dfs(el.first)) {
-      std::cerr << Error{"Class " + el.first + ", or an ancestor of " + el.first +
+  for (std::uint32_t i = 0; i < names.size(); ++i) {
+    if (colours[i] == Colour::Cyclic) {
+      std::cerr << Error{"Class " + names[i].Str() + ", or an ancestor of " + names[i].Str() +
                          ", is involved in an inheritance cycle."};
       is_acyclic = false;
     }
@@ -85,48 +109,84 @@ bool InheritanceGraph::CheckAcyclic() const {
 }
 
 bool InheritanceGraph::HasMain() const {
-  return _classes_graph.contains("Main") || (std::cerr << Error{"Class Main is not defined."}, false);
+  return _classes_graph.contains(symbols::kMain) || (std::cerr << Error{"Class Main is not defined."}, false);
 }
 
-bool InheritanceGraph::IsBasic(std::string_view class_name) {
+bool InheritanceGraph::IsBasic(Symbol class_name) {
   return std::find(fundamentals.begin(), fundamentals.end(), class_name) != fundamentals.end();
 }
 
-void InheritanceGraph::CalculateDepth(const std::string& class_name) {
-  if (class_name == "Object") {
-    _height[class_name] = 0;
-  }
-  const auto& base = _classes_graph[class_name];
-
-  if (!_height.contains(base)) {
-    CalculateDepth(base);
+// pre-condition: CheckAndFill Method must be called
+Symbol InheritanceGraph::GetLca(Symbol left, Symbol right) const {
+  auto begin = _first[At(left)];
+  auto end = _first[At(right)];
+  if (begin > end) {
+    std::swap(begin, end);
   }
-  _height[class_name] = _height[base] + 1;
+  auto level = std::bit_width(end - begin + 1) - 1;
+  const auto* row = &_sparse[level * _tour_size];
+  return _names[std::min(row[begin], row[end + 1 - (std::size_t{1} << level)])];
 }
 
-// pre-condition: CheckAndFill Method must be called
-std::string InheritanceGraph::GetLca(std::string_view left, std::string_view right) const {
-  int left_h = _height.at(left);
-  std::vector<std::string_view> left_path(left_h + 1);
-  for (; left_h >= 0; left_h--) {
-    left_path[left_h] = left;
-    left = _classes_graph.at(std::string{left});
+void InheritanceGraph::BuildIndex() {
+  std::unordered_map<Symbol, std::vector<Symbol>> children;
+  std::uint32_t max_symbol = 0;
+  for (const auto& [cl, parent] : _classes_graph) {
+    if (cl != symbols::kObject) {
+      children[parent].push_back(cl);
+    }
+    max_symbol = std::max(max_symbol, cl.Id());
   }
-
-  int right_h = _height.at(right);
-  std::vector<std::string_view> right_path(right_h + 1);
-  for (; right_h >= 0; right_h--) {
-    right_path[right_h] = right;
-    right = _classes_graph.at(std::string{right});
+  auto size = _classes_graph.size();
+  _ids.assign(max_symbol + 1, kNoClass);
+  _names.clear();
+  _depths.clear();
+  _parents.clear();
+  _last.assign(size, 0);
+  _first.assign(size, 0);
+  std::vector<ClassId> tour;
+  tour.reserve(2 * size);
+
+  // iterative DFS, a frame is a class and the number of its children visited so far
+  std::vector<std::pair<ClassId, std::size_t>> stack;
+  auto enter = [&](Symbol cl, ClassId parent) {
+    auto id = static_cast<ClassId>(_names.size());
+    _ids[cl.Id()] = id;
+    _names.push_back(cl);
+    _parents.push_back(parent);
+    _depths.push_back(parent == kNoClass ? 0 : _depths[parent] + 1);
+    _first[id] = static_cast<std::uint32_t>(tour.size());
+    tour.push_back(id);
+    stack.emplace_back(id, 0);
+  };
+  enter(symbols::kObject, kNoClass);
+  while (!stack.empty()) {
+    auto [id, visited] = stack.back();
+    auto it = children.find(_names[id]);
+    if (it != children.end() && visited < it->second.size()) {
+      ++stack.back().second;
+      enter(it->second[visited], id);
+      continue;
+    }
+    _last[id] = static_cast<ClassId>(_names.size() - 1);
+    stack.pop_back();
+    if (!stack.empty()) {
+      tour.push_back(stack.back().first);
+    }
   }
 
-  std::size_t i = 0;
-  for (; i < std::min(left_path.size(), right_path.size()); i++) {
-    if (left_path[i] != right_path[i]) {
-      break;
+  _tour_size = tour.size();
+  auto levels = static_cast<std::size_t>(std::bit_width(_tour_size));
+  _sparse.resize(levels * _tour_size);
+  std::copy(tour.begin(), tour.end(), _sparse.begin());
+  for (std::size_t level = 1; level < levels; ++level) {
+    const auto* previous = &_sparse[(level - 1) * _tour_size];
+    auto* row = &_sparse[level * _tour_size];
+    auto half = std::size_t{1} << (level - 1);
+    for (std::size_t i = 0; i + 2 * half <= _tour_size; ++i) {
+      row[i] = std::min(previous[i], previous[i + half]);
     }
   }
-  return std::string{left_path[i - 1]};
 }
 
 bool InheritanceGraph::FillAndCheck(const Program& p) {
@@ -142,12 +202,7 @@ bool InheritanceGraph::FillAndCheck(const Program& p) {
 
   CHECK_ERROR(correct && CheckAcyclic() && HasMain())
 
-  for (const auto& el : _classes_graph) {
-    if (!_height.contains(el.first)) {
-      CalculateDepth(el.first);
-    }
-  }
-
+  BuildIndex();
   return true;
 }
 
@@ -1,11 +1,15 @@
 #pragma once
 #include "ast/expression.hpp"
 #include "semant/error.hpp"
+#include "symbol/symbol.hpp"
 
 #include <array>
 #include <cassert>
+#include <cstdint>
 #include <functional>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -25,15 +29,22 @@
 
 namespace coolc {
 
+/// Classes and their parents. After FillAndCheck every class has a dense id: ids are assigned in DFS pre-order from
+/// Object, so the subtree of a class is the id range [id, last[id]] and conformance is an interval test. Lowest
+/// common ancestors are range minima of ids over the Euler tour of the tree, answered by a sparse table in O(1).
 class InheritanceGraph {
  public:
-  constexpr static std::array fundamentals{"String", "IO", "Int", "Bool", "Object"};
+  using ClassId = std::uint32_t;
+  static constexpr ClassId kNoClass = std::numeric_limits<ClassId>::max();
+
+  constexpr static std::array fundamentals{symbols::kString, symbols::kIO, symbols::kInt, symbols::kBool,
+                                           symbols::kObject};
 
   InheritanceGraph();
   void Reserve(std::size_t size);
   bool InsertClass(const Class& cl);
 
-  bool IsBasic(std::string_view class_name);
+  bool IsBasic(Symbol class_name);
 
   bool FillAndCheck(const Program& p);
 
@@ -43,36 +54,85 @@ class InheritanceGraph {
 
   bool HasMain() const;
 
-  bool HasClass(std::string class_name) const {
+  bool HasClass(Symbol class_name) const {
     return _classes_graph.contains(class_name);
   }
 
-  void CalculateDepth(const std::string& class_name);
-
   bool CheckAncessorDefined(const Class& cl) const;
 
-  std::string GetAncessor(std::string class_name) const {
+  Symbol GetAncessor(Symbol class_name) const {
     return _classes_graph.at(class_name);
   }
 
-  bool IsAncessor(std::string_view base, std::string_view derived) const {
-    if (derived == "SELF_TYPE") {
+  /// Dense id of the class, kNoClass if it is not defined or FillAndCheck has not succeeded
+  ClassId Id(Symbol class_name) const {
+    auto index = class_name.Id();
+    return index < _ids.size() ? _ids[index] : kNoClass;
+  }
+
+  /// number of classes with ids
+  std::size_t Size() const {
+    return _names.size();
+  }
+
+  Symbol Name(ClassId id) const {
+    return _names[id];
+  }
+
+  /// the largest id in the subtree of the class, the ids of its subtree are the ones from id to Last(id)
+  ClassId Last(ClassId id) const {
+    return _last[id];
+  }
+
+  /// kNoClass for Object
+  ClassId Parent(ClassId id) const {
+    return _parents[id];
+  }
+
+  /// number of edges between the class and Object
+  std::size_t Depth(Symbol class_name) const {
+    return _depths[At(class_name)];
+  }
+
+  /// true if derived conforms to base, SELF_TYPE conforms to everything
+  bool IsAncessor(Symbol base, Symbol derived) const {
+    if (derived == symbols::kSelfType) {
       return true;
     }
-    while (derived != "Object") {
-      if (derived == base) {
-        return true;
-      }
-      derived = _classes_graph.at(std::string(derived));
-    }
-    return base == derived;
+    auto base_id = Id(base);
+    auto derived_id = Id(derived);
+    return base_id != kNoClass && derived_id != kNoClass && base_id <= derived_id && derived_id <= _last[base_id];
+  }
+
+  bool IsAncessor(ClassId base, ClassId derived) const {
+    return base <= derived && derived <= _last[base];
   }
 
-  std::string GetLca(std::string_view left, std::string_view right) const;
+  /// pre-condition: both classes are defined, throws std::out_of_range otherwise
+  Symbol GetLca(Symbol left, Symbol right) const;
 
  private:
-  std::unordered_map<std::string_view, std::size_t> _height;
-  std::unordered_map<std::string, std::string> _classes_graph;
+  ClassId At(Symbol class_name) const {
+    auto id = Id(class_name);
+    if (id == kNoClass) {
+      throw std::out_of_range{"class " + class_name.Str() + " is not defined"};
+    }
+    return id;
+  }
+
+  /// assigns the ids and builds the tables of the queries, pre-condition: the graph is a tree rooted at Object
+  void BuildIndex();
+
+  std::unordered_map<Symbol, Symbol> _classes_graph;
+
+  std::vector<ClassId> _ids;  // by Symbol::Id()
+  std::vector<Symbol> _names;
+  std::vector<ClassId> _parents;
+  std::vector<std::uint32_t> _depths;
+  std::vector<ClassId> _last;         // the largest id in the subtree
+  std::vector<std::uint32_t> _first;  // the first position in the Euler tour
+  std::size_t _tour_size{0};
+  std::vector<ClassId> _sparse;  // level k holds the minima of the tour ranges of length 2^k, levels are contiguous
 };
 
 }  // namespace coolc
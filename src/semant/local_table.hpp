@@ -0,0 +1,112 @@
+#pragma once
+
+#include "symbol/symbol.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace coolc {
+
+/// Local bindings of a method body: formals, let and case variables.
+/// One open-addressing table with linear probing maps a name to its innermost binding. Bindings live in an undo log
+/// and link to the bindings they shadow, leaving a scope pops the log down to the mark of the scope and puts the
+/// shadowed bindings back. A name keeps its slot once inserted, so nothing is erased from the table, and nothing is
+/// allocated once the table and the log have grown to the largest method.
+class LocalTable {
+ public:
+  LocalTable() : _slots(kInitialCapacity) {
+  }
+
+  void Enter() {
+    _marks.push_back(_log.size());
+  }
+
+  void Leave() {
+    assert(!_marks.empty());
+    for (auto mark = _marks.back(); _log.size() > mark; _log.pop_back()) {
+      _slots[Probe(_log.back().name)].binding = _log.back().shadowed;
+    }
+    _marks.pop_back();
+  }
+
+  /// number of entered scopes
+  std::size_t Depth() const {
+    return _marks.size();
+  }
+
+  /// Binds the name in the innermost scope, false if it is already bound there
+  bool Bind(Symbol name, Symbol type) {
+    assert(!_marks.empty());
+    if (2 * (_used + 1) > _slots.size()) {
+      Grow();
+    }
+    auto& slot = _slots[Probe(name)];
+    if (!slot.used) {
+      slot = {name, kNone, true};
+      ++_used;
+    }
+    if (slot.binding != kNone && _log[slot.binding].depth == _marks.size()) {
+      return false;
+    }
+    _log.push_back({name, type, slot.binding, static_cast<std::uint32_t>(_marks.size())});
+    slot.binding = static_cast<std::uint32_t>(_log.size() - 1);
+    return true;
+  }
+
+  /// type of the innermost binding of the name
+  std::optional<Symbol> Find(Symbol name) const {
+    const auto& slot = _slots[Probe(name)];
+    if (!slot.used || slot.binding == kNone) {
+      return std::nullopt;
+    }
+    return _log[slot.binding].type;
+  }
+
+ private:
+  static constexpr std::uint32_t kNone = static_cast<std::uint32_t>(-1);
+  static constexpr std::size_t kInitialCapacity = 64;
+
+  struct Slot {
+    Symbol name;
+    std::uint32_t binding{kNone};
+    bool used{false};
+  };
+
+  struct Binding {
+    Symbol name;
+    Symbol type;
+    std::uint32_t shadowed;
+    std::uint32_t depth;
+  };
+
+  /// the slot of the name or the empty slot where it would be inserted
+  std::size_t Probe(Symbol name) const {
+    auto mask = _slots.size() - 1;
+    // Fibonacci hashing spreads the sequential ids of symbols
+    auto index = static_cast<std::size_t>((name.Id() * std::uint64_t{0x9E3779B97F4A7C15}) >> 32) & mask;
+    while (_slots[index].used && _slots[index].name != name) {
+      index = (index + 1) & mask;
+    }
+    return index;
+  }
+
+  void Grow() {
+    std::vector<Slot> old(_slots.size() * 2);
+    old.swap(_slots);
+    for (const auto& slot : old) {
+      if (slot.used) {
+        _slots[Probe(slot.name)] = slot;
+      }
+    }
+  }
+
+  std::vector<Slot> _slots;
+  std::size_t _used{0};
+  std::vector<Binding> _log;
+  std::vector<std::size_t> _marks;
+};
+
+}  // namespace coolc
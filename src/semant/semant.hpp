@@ -1,57 +1,42 @@
 #pragma once
 
 #include "ast/expression.hpp"
+#include "semant/class_layout.hpp"
 #include "semant/error.hpp"
 #include "semant/inheritance_graph.hpp"
-#include "semant/scope.hpp"
+#include "semant/type_checker.hpp"
+#include "util/thread_pool.hpp"
 
-#include <stack>
+#include <cstddef>
 
 namespace coolc {
 
-using MaybeType = std::optional<std::string>;
-
 class Semant {
  public:
   Semant(Program&& p);
 
   bool CheckProgram();
 
+  static constexpr std::size_t kMinParallelClasses = 64;
+
+  /// Same result, types and diagnostics as CheckProgram(), class bodies are checked by chunks on the pool.
+  /// Every chunk buffers its diagnostics and stops at its first failing class, the buffers are printed in the order of
+  /// the classes up to the first failure, so the output is the one of the serial check. An exception of a class is
+  /// rethrown only if no class before it has failed, as in the serial check.
+  bool CheckProgram(util::ThreadPool& pool, std::size_t min_classes = kMinParallelClasses);
+
   const Program& GetProgram() const;
 
+  /// pre-condition: CheckProgram succeeded
+  const ClassLayouts& GetLayouts() const;
+
   bool CheckClasses();
-  bool FillContent(const Class& cl);
-  bool CheckClass(const Class& cl);
-  bool CheckFeature(const Feature& f);
-  bool CheckMethod(const Method& m);
-  bool CheckAttribute(const Attribute& a);
-
-  MaybeType CheckInversion(const Inversion& expr);
-  MaybeType CheckIsVoid(const IsVoid&);
-  MaybeType CheckNot(const Not& a);
-  MaybeType CheckBlock(const Block& a);
-  MaybeType CheckIf(const If& a);
-  MaybeType CheckWhile(const While& a);
-  MaybeType CheckId(const Id& a);
-  MaybeType CheckEqual(const Equal& a);
-  MaybeType CheckAssignment(const Assign& a);
-  MaybeType CheckLet(const Let& a);
-  MaybeType CheckCase(const Case& a);
-  MaybeType CheckDispatch(const Dispatch& a);
-  MaybeType CheckNew(const New& a);
-
-  template <Arithmetic T>
-  MaybeType CheckArithmetic(const T& expr);
-
-  template <Comparison T>
-  MaybeType CheckComparison(const T& a);
-
-  MaybeType CheckExpression(std::shared_ptr<Expression> expr);
+  bool CheckClasses(util::ThreadPool& pool, std::size_t min_classes);
 
  private:
   Program _p;
   InheritanceGraph _ig;
-  Scope _ctx;
+  ClassLayouts _layouts;
 };
 
 }  // namespace coolc
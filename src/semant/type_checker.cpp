@@ -0,0 +1,351 @@
+#include "semant/type_checker.hpp"
+
+#include "ast/expression.hpp"
+#include "semant/error.hpp"
+#include "semant/inheritance_graph.hpp"
+#include "util/type_traits.hpp"
+
+#include <iterator>
+#include <optional>
+#include <ostream>
+#include <unordered_set>
+#include <vector>
+
+namespace coolc {
+
+namespace {
+bool CheckCaseNoIdenticalBranches(const Case& a, std::ostream& err) {
+  std::unordered_set<Symbol> case_branches{};
+  for (const auto& el : a.cases) {
+    if (!case_branches.insert(el.type_id).second) {
+      err << "Case identical branches" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+TypeChecker::TypeChecker(const InheritanceGraph& ig, const ClassLayouts& layouts, std::ostream& out,
+                         std::ostream& err)
+    : _ig(ig), _ctx(ig, layouts), _out(out), _err(err) {
+}
+
+bool TypeChecker::CheckClass(const Class& cl) {
+  ScopeGuard new_scope(&_ctx, cl);
+  for (const auto& el : cl.features) {
+    CHECK_ERROR(CheckFeature(el))
+  }
+  return true;
+}
+
+bool TypeChecker::CheckFeature(const Feature& f) {
+  return std::visit(util::Overloaded{[this](const Method& m) { return CheckMethod(m); },
+                                     [this](const Attribute& a) { return CheckAttribute(a); }},
+                    f.feature);
+}
+
+bool TypeChecker::CheckMethod(const Method& m) {
+  ScopeGuard new_scope(&_ctx);
+  for (const auto& f : m.formals) {
+    if (f.type_id == symbols::kSelfType) {
+      _err << "Formal parameter " << f.object_id << " cannot have type SELF_TYPE." << std::endl;
+      return false;
+    }
+    CHECK_ERROR(_ctx.AddObject(f.object_id, f.type_id))
+  }
+  auto type = CheckExpression(m.expr);
+  CHECK_ERROR(type)
+  if (m.type_id == symbols::kSelfType && *type != symbols::kSelfType) {
+    _err << "Error here" << std::endl;
+    return {};
+  }
+  auto static_type = (m.type_id == symbols::kSelfType ? _ctx.current_class : m.type_id);
+  auto real_type = (*type == symbols::kSelfType ? _ctx.current_class : *type);
+  if (!_ig.IsAncessor(static_type, real_type)) {
+    _err << "Inferred return type " << real_type << " of method " << m.object_id
+         << " does not conform to declared return type " << m.type_id << "." << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool TypeChecker::CheckAttribute(const Attribute& a) {
+  if (a.expr->Is<Empty>()) {
+    return true;
+  }
+  auto type = CheckExpression(a.expr);
+  CHECK_ERROR(type)
+  if (*type == symbols::kSelfType) {
+    *type = _ctx.current_class;
+  }
+  auto x = (bool)type;
+  auto y = _ig.GetLca(*type, a.type_id) == a.type_id;
+  if (!x || !y) {
+    _out << "KEEEK" << std::endl;
+  }
+  return type && _ig.GetLca(*type, a.type_id) == a.type_id;
+}
+
+template <Arithmetic T>
+MaybeType TypeChecker::CheckArithmetic(const T& expr) {
+  auto left = CheckExpression(expr.lhs);
+  CHECK_NULLOPT(left && *left == symbols::kInt)
+  auto right = CheckExpression(expr.rhs);
+  CHECK_NULLOPT(right && *right == symbols::kInt)
+  return symbols::kInt;
+}
+
+MaybeType TypeChecker::CheckInversion(const Inversion& expr) {
+  auto inv_type = CheckExpression(expr.arg);
+  CHECK_NULLOPT(inv_type && *inv_type == symbols::kInt)
+  return symbols::kInt;
+}
+
+MaybeType TypeChecker::CheckIsVoid(const IsVoid& a) {
+  CHECK_NULLOPT(CheckExpression(a.arg))
+  return symbols::kBool;
+}
+
+MaybeType TypeChecker::CheckNot(const Not& a) {
+  auto l_type = CheckExpression(a.arg);
+  CHECK_NULLOPT(l_type && *l_type == symbols::kBool)
+  return symbols::kBool;
+}
+
+template <Comparison T>
+MaybeType TypeChecker::CheckComparison(const T& a) {
+  auto l_type = CheckExpression(a.lhs);
+  CHECK_NULLOPT(l_type && *l_type == symbols::kInt)
+  auto r_type = CheckExpression(a.rhs);
+  CHECK_NULLOPT(r_type && *r_type == symbols::kInt)
+  return symbols::kBool;
+}
+
+MaybeType TypeChecker::CheckBlock(const Block& a) {
+  for (auto it = a.expr.begin(); it != std::prev(a.expr.end()); ++it) {
+    CHECK_NULLOPT(CheckExpression(*it))
+  }
+  return CheckExpression(*std::prev(a.expr.end()));
+}
+
+MaybeType TypeChecker::CheckIf(const If& a) {
+  auto cond_type = CheckExpression(a.condition);
+  CHECK_NULLOPT(cond_type && *cond_type == symbols::kBool)
+  auto then_type = CheckExpression(a.then_expr);
+  CHECK_NULLOPT(then_type)
+  auto else_type = CheckExpression(a.else_expr);
+  CHECK_NULLOPT(else_type)
+  // TODO: to think about this code, its bad and maybe incorrect (!?)
+  if (*then_type == symbols::kSelfType && *else_type == symbols::kSelfType) {
+    return {symbols::kSelfType};
+  }
+  if (*then_type == symbols::kSelfType) {
+    *then_type = _ctx.current_class;
+  }
+  if (*else_type == symbols::kSelfType) {
+    *else_type = _ctx.current_class;
+  }
+  return _ig.GetLca(*then_type, *else_type);
+}
+
+MaybeType TypeChecker::CheckWhile(const While& a) {
+  auto cond_type = CheckExpression(a.condition);
+  CHECK_NULLOPT(cond_type && *cond_type == symbols::kBool)
+  CHECK_NULLOPT(CheckExpression(a.loop_body))
+  return symbols::kObject;
+}
+
+MaybeType TypeChecker::CheckId(const Id& a) {
+  if (a.name == symbols::kSelf) {
+    return symbols::kSelfType;
+  }
+  return _ctx.GetAttrObject(a.name);
+}
+
+MaybeType TypeChecker::CheckEqual(const Equal& a) {
+  auto lhs = CheckExpression(a.lhs);
+  CHECK_NULLOPT(lhs)
+  auto rhs = CheckExpression(a.rhs);
+  CHECK_NULLOPT(rhs)
+  if (*lhs == symbols::kInt || *lhs == symbols::kString || *lhs == symbols::kBool || *rhs == symbols::kInt ||
+      *rhs == symbols::kString || *rhs == symbols::kBool) {
+    CHECK_NULLOPT(*lhs == *rhs)
+  }
+  return symbols::kBool;
+}
+
+MaybeType TypeChecker::CheckLet(const Let& a) {
+  // nested lets share the scope of the outermost one
+  std::optional<ScopeGuard> new_scope;
+  if (_let_depth == 0) {
+    new_scope.emplace(&_ctx);
+  }
+
+  for (const auto& el : a.attrs) {
+    if (el.object_id == symbols::kSelf) {
+      _err << "'self' cannot be bound in a 'let' expression." << std::endl;
+      return {};
+    }
+    auto lhs = el.type_id == symbols::kSelfType ? _ctx.current_class : el.type_id;
+
+    if (!el.expr->Is<Empty>()) {
+      auto rhs = CheckExpression(el.expr);
+      CHECK_NULLOPT(rhs)
+      if (!_ig.IsAncessor(lhs, *rhs)) {
+        _err << "Inferred type " << *rhs << " of initialization of " << el.object_id
+             << " does not conform to identifiers declared type " << lhs << std::endl;
+        return {};
+      }
+    }
+    _ctx.AddObject(el.object_id, el.type_id);
+  }
+  _let_depth++;
+  auto res = CheckExpression(a.expr);
+  _let_depth--;
+  return res;
+}
+
+MaybeType TypeChecker::CheckCase(const Case& a) {
+  CHECK_NULLOPT(CheckExpression(a.expr))
+  CHECK_NULLOPT(CheckCaseNoIdenticalBranches(a, _err))
+  std::vector<Symbol> types;
+  for (const auto& el : a.cases) {
+    ScopeGuard new_scope(&_ctx);
+    _ctx.AddObject(el.object_id, el.type_id);
+    auto type = CheckExpression(el.expr);
+    CHECK_NULLOPT(type)
+    types.emplace_back(*type);
+  }
+
+  Symbol result = types[0];
+  std::size_t self_type_counter{0};
+  if (result == symbols::kSelfType) {
+    result = _ctx.current_class;
+    self_type_counter++;
+  }
+  for (size_t i = 1; i < types.size(); i++) {
+    if (types[i] == symbols::kSelfType) {
+      types[i] = _ctx.current_class;
+      self_type_counter++;
+    }
+    result = _ig.GetLca(result, types[i]);
+  }
+  if (self_type_counter == types.size()) {
+    return {symbols::kSelfType};
+  }
+  return {result};
+}
+
+MaybeType TypeChecker::CheckDispatch(const Dispatch& a) {
+  auto dispatch_expr = CheckExpression(a.expr);
+  CHECK_NULLOPT(dispatch_expr)
+
+  std::vector<Symbol> arg_types;
+  for (const auto& arg : a.parameters) {
+    auto arg_type = CheckExpression(arg);
+    CHECK_NULLOPT(arg_type)
+    if (arg_type == symbols::kSelfType) {
+      arg_type = _ctx.current_class;
+    }
+    // CHECK_NULLOPT(*arg_type != symbols::kSelfType)
+    arg_types.push_back(*arg_type);
+  }
+
+  Symbol dispatch_type;
+  if (a.type_id) {
+    if (!_ig.IsAncessor(*a.type_id, (*dispatch_expr == symbols::kSelfType ? _ctx.current_class : *dispatch_expr))) {
+      _err << "Expression type SELF_TYPE does not conform to declared static dispatch type C." << std::endl;
+      // _out << "Lol" << std::endl;
+      return {};
+    }
+    dispatch_type = *a.type_id;
+  } else if (*dispatch_expr == symbols::kSelfType) {
+    dispatch_type = _ctx.current_class;
+  } else {
+    dispatch_type = *dispatch_expr;
+  }
+
+  auto d = _ctx.GetMethod(dispatch_type, a.object_id->name);
+  if (!d) {
+    _err << "Error message 3" << std::endl;
+    return {};
+  }
+
+  if (arg_types.size() != d->args_types.size()) {
+    // TODO: make error message
+    _err << "Error message 2" << std::endl;
+    return {};
+  }
+  for (size_t i = 0; i < arg_types.size(); i++) {
+    auto loc = (arg_types[i] == symbols::kSelfType ? _ctx.current_class : arg_types[i]);
+    if (!_ig.IsAncessor(d->args_types[i], loc)) {
+      // TODO: make error message
+      _err << "Error message 1" << std::endl;
+      return {};
+    }
+  }
+
+  auto result = d->return_type == symbols::kSelfType ? dispatch_type : d->return_type;
+  if (d->return_type == symbols::kSelfType && ((a.expr->Is<Id>() && a.expr->As<Id>()->name == symbols::kSelf) ||
+                                               (a.expr->Is<Dispatch>() && a.expr->type == symbols::kSelfType))) {
+    return symbols::kSelfType;
+  }
+  return result;
+}
+
+MaybeType TypeChecker::CheckAssignment(const Assign& a) {
+  if (a.identifier == symbols::kSelf) {
+    _err << "Error Kek" << std::endl;
+    return {};
+  }
+  auto lhs = _ctx.GetAttrObject(a.identifier);
+  CHECK_NULLOPT(lhs)
+  auto rhs = CheckExpression(a.rhs);
+  CHECK_NULLOPT(rhs)
+  CHECK_NULLOPT(_ig.IsAncessor(*lhs, *rhs));
+  return *rhs;
+}
+
+MaybeType TypeChecker::CheckNew(const New& a) {
+  if (a.type == symbols::kSelfType) {
+    return symbols::kSelfType;  // _ctx.current_class;
+  }
+  return a.type;
+}
+
+MaybeType TypeChecker::CheckExpression(Expression* expr) {
+  // clang-format off
+  auto type = std::visit(
+      util::Overloaded{
+          [](const Int&) -> MaybeType { return symbols::kInt; },
+          [](const String&) -> MaybeType { return symbols::kString; },
+          [](const Bool&) -> MaybeType { return symbols::kBool; },
+          [this](const Arithmetic auto& a) -> MaybeType { return CheckArithmetic(a); },
+          [this](const Inversion& a) -> MaybeType { return CheckInversion(a); },
+          [this](const IsVoid& a) -> MaybeType { return CheckIsVoid(a); },
+          [this](const Not& a) -> MaybeType { return CheckNot(a); },
+          [this](const Comparison auto& a) -> MaybeType { return CheckComparison(a); },
+          [this](const Block& a) -> MaybeType { return CheckBlock(a); },
+          [this](const If& a) -> MaybeType { return CheckIf(a); },
+          [this](const While& a) -> MaybeType { return CheckWhile(a); },
+          [this](const Equal& a) -> MaybeType { return CheckEqual(a); },
+          [this](const Id& a) -> MaybeType { return CheckId(a); },
+          [this](const New& a) -> MaybeType { return CheckNew(a); },
+          [this](const Assign& a) -> MaybeType { return CheckAssignment(a); },
+          [this](const Dispatch& a) -> MaybeType { return CheckDispatch(a); },
+          [this](const Case& a) -> MaybeType { return CheckCase(a); },
+          [this](const Let& a) -> MaybeType { return CheckLet(a);; },
+          [this](const Empty&) -> MaybeType { return symbols::kNoType; }},
+      expr->data_);
+  // clang-format on
+  if (type && !_ig.HasClass(*type) && *type != symbols::kSelfType) {
+    type.reset();
+  }
+  if (type) {
+    expr->type = *type;
+  }
+  return type;
+}
+
+}  // namespace coolc
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "ast/expression.hpp"
+#include "semant/class_layout.hpp"
+#include "semant/inheritance_graph.hpp"
+#include "semant/scope.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <ostream>
+
+namespace coolc {
+
+using MaybeType = std::optional<Symbol>;
+
+/// Checks class bodies against the global environment, the inheritance graph and the class layouts, which it only
+/// reads. Its own state is the local scope stack, so checkers of different classes may run on different threads.
+/// Inferred types are written into the expressions of the checked class, diagnostics go to out and err.
+class TypeChecker {
+ public:
+  TypeChecker(const InheritanceGraph& ig, const ClassLayouts& layouts, std::ostream& out, std::ostream& err);
+
+  bool CheckClass(const Class& cl);
+  bool CheckFeature(const Feature& f);
+  bool CheckMethod(const Method& m);
+  bool CheckAttribute(const Attribute& a);
+
+  MaybeType CheckInversion(const Inversion& expr);
+  MaybeType CheckIsVoid(const IsVoid&);
+  MaybeType CheckNot(const Not& a);
+  MaybeType CheckBlock(const Block& a);
+  MaybeType CheckIf(const If& a);
+  MaybeType CheckWhile(const While& a);
+  MaybeType CheckId(const Id& a);
+  MaybeType CheckEqual(const Equal& a);
+  MaybeType CheckAssignment(const Assign& a);
+  MaybeType CheckLet(const Let& a);
+  MaybeType CheckCase(const Case& a);
+  MaybeType CheckDispatch(const Dispatch& a);
+  MaybeType CheckNew(const New& a);
+
+  template <Arithmetic T>
+  MaybeType CheckArithmetic(const T& expr);
+
+  template <Comparison T>
+  MaybeType CheckComparison(const T& a);
+
+  MaybeType CheckExpression(Expression* expr);
+
+ private:
+  const InheritanceGraph& _ig;
+  Scope _ctx;
+  std::ostream& _out;
+  std::ostream& _err;
+  std::size_t _let_depth{0};
+};
+
+}  // namespace coolc
@@ -0,0 +1,170 @@
+#include "symbol/symbol.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace coolc {
+
+/// Texts are copied into append-only blocks and indexed by chunks that never move,
+/// so string_views handed out by Get stay valid while other threads intern new symbols.
+/// Symbols are found by an open addressing index whose slots are published after the text they refer to, so a lookup
+/// of an interned symbol reads the index without the lock. Writers hold the lock; a full index is copied into a twice
+/// larger one, and the old one is kept alive for the readers which still probe it.
+struct SymbolTable::Impl {
+  static constexpr std::size_t kChunkBits = 16;
+  static constexpr std::size_t kChunkSize = std::size_t{1} << kChunkBits;
+  static constexpr std::size_t kMaxChunks = std::size_t{1} << 12;
+  static constexpr std::size_t kBlockSize = std::size_t{1} << 16;
+  static constexpr std::size_t kMinIndexSize = std::size_t{1} << 10;
+
+  /// a slot holds the high half of the hash of the text and the id plus one, zero is a free slot
+  struct Index {
+    explicit Index(std::size_t size) : mask{size - 1}, slots{new std::atomic<std::uint64_t>[size]} {
+      for (std::size_t i = 0; i < size; ++i) {
+        slots[i].store(0, std::memory_order_relaxed);
+      }
+    }
+
+    std::size_t mask;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> slots;
+  };
+
+  static std::uint64_t Tag(std::size_t hash) {
+    return static_cast<std::uint64_t>(hash) >> 32 << 32;
+  }
+
+  std::string_view At(std::uint32_t id) const {
+    auto* chunk = chunks[id >> kChunkBits].load(std::memory_order_acquire);
+    return chunk[id & (kChunkSize - 1)];
+  }
+
+  /// id plus one of the text, zero if it is not in the index
+  std::uint64_t Find(const Index& index, std::string_view text, std::size_t hash) const {
+    for (auto i = hash & index.mask;; i = (i + 1) & index.mask) {
+      auto slot = index.slots[i].load(std::memory_order_acquire);
+      if (slot == 0) {
+        return 0;
+      }
+      auto id = static_cast<std::uint32_t>(slot) - 1;
+      if ((slot & ~std::uint64_t{0xffffffff}) == Tag(hash) && At(id) == text) {
+        return id + 1;
+      }
+    }
+  }
+
+  /// pre-condition: the lock is held
+  static void Insert(Index& index, std::uint64_t slot, std::size_t hash) {
+    auto i = hash & index.mask;
+    while (index.slots[i].load(std::memory_order_relaxed) != 0) {
+      i = (i + 1) & index.mask;
+    }
+    index.slots[i].store(slot, std::memory_order_release);
+  }
+
+  /// keeps the index at most half full, pre-condition: the lock is held
+  void Reserve(std::size_t symbols) {
+    auto* current = index.load(std::memory_order_relaxed);
+    if (current && 2 * symbols <= current->mask + 1) {
+      return;
+    }
+    auto next = std::make_unique<Index>(current ? 2 * (current->mask + 1) : kMinIndexSize);
+    for (std::uint32_t id = 0; current && id < size.load(std::memory_order_relaxed); ++id) {
+      auto text = At(id);
+      auto hash = std::hash<std::string_view>{}(text);
+      Insert(*next, Tag(hash) | (id + 1), hash);
+    }
+    index.store(next.get(), std::memory_order_release);
+    indexes.push_back(std::move(next));
+  }
+
+  std::string_view Store(std::string_view text) {
+    if (text.size() > block_left) {
+      auto size = std::max(kBlockSize, text.size());
+      blocks.push_back(std::make_unique<char[]>(size));
+      block_pos = blocks.back().get();
+      block_left = size;
+    }
+    std::memcpy(block_pos, text.data(), text.size());
+    std::string_view stored{block_pos, text.size()};
+    block_pos += text.size();
+    block_left -= text.size();
+    return stored;
+  }
+
+  std::array<std::atomic<std::string_view*>, kMaxChunks> chunks{};
+  std::vector<std::unique_ptr<std::string_view[]>> chunks_storage;
+  std::atomic<std::uint32_t> size{0};
+  std::atomic<Index*> index{nullptr};
+
+  std::mutex mutex;
+  std::vector<std::unique_ptr<Index>> indexes;
+  std::vector<std::unique_ptr<char[]>> blocks;
+  char* block_pos{nullptr};
+  std::size_t block_left{0};
+};
+
+SymbolTable& SymbolTable::Instance() {
+  // never destroyed: symbols may be printed from destructors of other static objects
+  static auto* table = new SymbolTable;
+  return *table;
+}
+
+SymbolTable::SymbolTable() : _impl{new Impl} {
+  for (auto text : detail::kPredefinedSymbols) {
+    [[maybe_unused]] auto symbol = Intern(text);
+    assert(Get(symbol) == text);
+  }
+}
+
+Symbol SymbolTable::Intern(std::string_view text) {
+  auto hash = std::hash<std::string_view>{}(text);
+  if (auto* index = _impl->index.load(std::memory_order_acquire); index) {
+    if (auto found = _impl->Find(*index, text, hash); found) {
+      return Symbol{static_cast<std::uint32_t>(found - 1)};
+    }
+  }
+  std::lock_guard lock(_impl->mutex);
+  // another thread may have interned the text since the lookup, or grown the index
+  if (auto* index = _impl->index.load(std::memory_order_relaxed); index) {
+    if (auto found = _impl->Find(*index, text, hash); found) {
+      return Symbol{static_cast<std::uint32_t>(found - 1)};
+    }
+  }
+  auto id = _impl->size.load(std::memory_order_relaxed);
+  auto chunk_index = id >> Impl::kChunkBits;
+  if (chunk_index == Impl::kMaxChunks) {
+    throw std::length_error{"symbol table is full: at most " + std::to_string(Impl::kMaxChunks * Impl::kChunkSize) +
+                            " symbols"};
+  }
+  auto* chunk = _impl->chunks[chunk_index].load(std::memory_order_relaxed);
+  if (!chunk) {
+    _impl->chunks_storage.push_back(std::make_unique<std::string_view[]>(Impl::kChunkSize));
+    chunk = _impl->chunks_storage.back().get();
+    _impl->chunks[chunk_index].store(chunk, std::memory_order_release);
+  }
+  _impl->Reserve(id + 1);
+  chunk[id & (Impl::kChunkSize - 1)] = _impl->Store(text);
+  _impl->size.store(id + 1, std::memory_order_release);
+  Impl::Insert(*_impl->index.load(std::memory_order_relaxed), Impl::Tag(hash) | (id + 1), hash);
+  return Symbol{id};
+}
+
+std::string_view SymbolTable::Get(Symbol symbol) const {
+  assert(symbol.Id() < Size());
+  return _impl->At(symbol.Id());
+}
+
+std::size_t SymbolTable::Size() const {
+  return _impl->size.load(std::memory_order_acquire);
+}
+
+}  // namespace coolc
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace coolc {
+
+/// Handle of an interned string: identifiers, type names, literals.
+/// Two symbols are equal iff their texts are equal, so they are compared and hashed as integers.
+class Symbol {
+ public:
+  constexpr Symbol() = default;
+  constexpr explicit Symbol(std::uint32_t id) : _id{id} {
+  }
+
+  /// Returns symbol of the text, adds it to the global table if it is new
+  static Symbol Intern(std::string_view text);
+
+  /// Text of the symbol, valid until the end of the program
+  std::string_view View() const;
+  std::string Str() const {
+    return std::string{View()};
+  }
+
+  constexpr std::uint32_t Id() const noexcept {
+    return _id;
+  }
+
+  friend constexpr bool operator==(Symbol lhs, Symbol rhs) noexcept = default;
+
+  friend std::ostream& operator<<(std::ostream& os, Symbol symbol) {
+    return os << symbol.View();
+  }
+
+ private:
+  std::uint32_t _id{0};
+};
+
+namespace detail {
+
+/// Interned at SymbolTable construction in this order, so their ids are known at compile time
+constexpr std::array<std::string_view, 21> kPredefinedSymbols{
+    "",         "Object",    "IO",         "Int",       "String",  "Bool",   "SELF_TYPE",
+    "self",     "Main",      "main",       "_no_type",  "length",  "substr", "concat",
+    "abort",    "type_name", "copy",       "out_string", "in_string", "out_int", "in_int"};
+
+consteval Symbol Predefined(std::string_view text) {
+  for (std::size_t i = 0; i < kPredefinedSymbols.size(); ++i) {
+    if (kPredefinedSymbols[i] == text) {
+      return Symbol{static_cast<std::uint32_t>(i)};
+    }
+  }
+  throw "symbol is not predefined";
+}
+
+}  // namespace detail
+
+namespace symbols {
+
+constexpr Symbol kEmpty = detail::Predefined("");
+constexpr Symbol kObject = detail::Predefined("Object");
+constexpr Symbol kIO = detail::Predefined("IO");
+constexpr Symbol kInt = detail::Predefined("Int");
+constexpr Symbol kString = detail::Predefined("String");
+constexpr Symbol kBool = detail::Predefined("Bool");
+constexpr Symbol kSelfType = detail::Predefined("SELF_TYPE");
+constexpr Symbol kSelf = detail::Predefined("self");
+constexpr Symbol kMain = detail::Predefined("Main");
+constexpr Symbol kMainMethod = detail::Predefined("main");
+constexpr Symbol kNoType = detail::Predefined("_no_type");
+constexpr Symbol kLength = detail::Predefined("length");
+constexpr Symbol kSubstr = detail::Predefined("substr");
+constexpr Symbol kConcat = detail::Predefined("concat");
+constexpr Symbol kAbort = detail::Predefined("abort");
+constexpr Symbol kTypeName = detail::Predefined("type_name");
+constexpr Symbol kCopy = detail::Predefined("copy");
+constexpr Symbol kOutString = detail::Predefined("out_string");
+constexpr Symbol kInString = detail::Predefined("in_string");
+constexpr Symbol kOutInt = detail::Predefined("out_int");
+constexpr Symbol kInInt = detail::Predefined("in_int");
+
+}  // namespace symbols
+
+/// Process wide string interner, filled by the lexer and read by all later passes.
+/// Intern is thread safe, only the first Intern of a text takes a lock, lookups of published symbols don't.
+class SymbolTable {
+ public:
+  static SymbolTable& Instance();
+
+  /// throw std::length_error if the table is full
+  Symbol Intern(std::string_view text);
+  std::string_view Get(Symbol symbol) const;
+  std::size_t Size() const;
+
+ private:
+  SymbolTable();
+  struct Impl;
+  Impl* _impl;
+};
+
+inline Symbol Symbol::Intern(std::string_view text) {
+  return SymbolTable::Instance().Intern(text);
+}
+
+inline std::string_view Symbol::View() const {
+  return SymbolTable::Instance().Get(*this);
+}
+
+}  // namespace coolc
+
+template <>
+struct std::hash<coolc::Symbol> {
+  std::size_t operator()(coolc::Symbol symbol) const noexcept {
+    return std::hash<std::uint32_t>{}(symbol.Id());
+  }
+};
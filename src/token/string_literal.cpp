@@ -0,0 +1,99 @@
+#include "token/string_literal.hpp"
+
+#include <array>
+#include <string>
+#include <string_view>
+
+namespace coolc {
+
+namespace {
+
+using EscapeTable = std::array<const char*, 256>;
+
+/// printable forms of the characters which appear in the literal as they are
+constexpr EscapeTable kRawEscapes = [] {
+  EscapeTable table{};
+  table['\t'] = "\\t";
+  table['\b'] = "\\b";
+  table['\r'] = "\\015";
+  table['\f'] = "\\f";
+  table['\033'] = "\\033";
+  table['\\'] = "\\\\";
+  table['\n'] = "\\n";
+  table['\x0b'] = "\\013";
+  table['\x12'] = "\\022";
+  return table;
+}();
+
+/// printable forms of the characters after a backslash, others are printed as the raw ones
+constexpr EscapeTable kSequenceEscapes = [] {
+  EscapeTable table{};
+  table['t'] = "\\t";
+  table['n'] = "\\n";
+  table['b'] = "\\b";
+  table['f'] = "\\f";
+  table['\033'] = "\\033";
+  table['\\'] = "\\\\";
+  table['"'] = "\\\"";
+  return table;
+}();
+
+const char* Lookup(const EscapeTable& table, char ch) {
+  return table[static_cast<unsigned char>(ch)];
+}
+
+}  // namespace
+
+std::string DecodeStringLiteral(std::string_view raw) {
+  std::string value;
+  value.reserve(raw.size());
+  while (!raw.empty()) {
+    auto backslash = raw.find('\\');
+    value.append(raw.substr(0, backslash));
+    if (backslash == std::string_view::npos || backslash + 1 == raw.size()) {
+      break;
+    }
+    switch (char ch = raw[backslash + 1]) {
+      case 'n':
+        value.push_back('\n');
+        break;
+      case 't':
+        value.push_back('\t');
+        break;
+      case 'b':
+        value.push_back('\b');
+        break;
+      case 'f':
+        value.push_back('\f');
+        break;
+      default:
+        value.push_back(ch);
+    }
+    raw.remove_prefix(backslash + 2);
+  }
+  return value;
+}
+
+std::string EscapeStringLiteral(std::string_view raw) {
+  std::string printed;
+  printed.reserve(raw.size());
+  for (std::size_t i = 0; i < raw.size(); ++i) {
+    char ch = raw[i];
+    const char* escape = nullptr;
+    if (ch == '\\' && i + 1 < raw.size()) {
+      ch = raw[++i];
+      escape = Lookup(kSequenceEscapes, ch);
+    }
+    if (escape == nullptr) {
+      escape = Lookup(kRawEscapes, ch);
+    }
+    if (escape != nullptr) {
+      printed.append(escape);
+    } else {
+      printed.push_back(ch);
+    }
+  }
+  return printed;
+}
+
+}  // namespace coolc
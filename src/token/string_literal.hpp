@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace coolc {
+
+/// Lexemes of string literals are raw slices of the source between the quotes, escape sequences included.
+/// They are decoded or escaped for printing only when needed, most literals are never looked at again.
+
+/// pre-condition: text is the text of a valid string literal token, quotes included
+constexpr std::string_view StringLiteralContent(std::string_view text) noexcept {
+  return text.substr(1, text.size() - 2);
+}
+
+/// Value of the literal: "\c" becomes c, except of \n, \t, \b and \f which become control characters
+std::string DecodeStringLiteral(std::string_view raw);
+
+/// Printable form of the literal for the lexer and parser dumps, without the enclosing quotes
+std::string EscapeStringLiteral(std::string_view raw);
+
+}  // namespace coolc
@@ -1,10 +1,13 @@
 #pragma once
 
+#include "symbol/symbol.hpp"
+
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <optional>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 
 namespace coolc {
 
@@ -62,25 +65,12 @@ struct Token {
     Size,
   };
 
-  // Only some tokens.
-  static Type FromString(const std::string& str) {
-    static std::unordered_map<std::string, Type> from_str{
-        {"class", Type::Class},   {"in", Type::In},     {"loop", Type::Loop},
-        {"pool", Type::Pool},     {"if", Type::If},     {"true", Type::True},
-        {"false", Type::False},   {"else", Type::Else}, {"inherits", Type::Inherits},
-        {"while", Type::While},   {"case", Type::Case}, {"fi", Type::Fi},
-        {"isvoid", Type::Isvoid}, {"esac", Type::Esac}, {"new", Type::New},
-        {"of", Type::Of},         {"not", Type::Not},   {"then", Type::Then},
-        {"let", Type::Let},       {"{", Type::LBrace},  {"}", Type::RBrace},
-        {"(", Type::LParen},      {")", Type::RParen},  {";", Type::Semicolon},
-        {":", Type::Colon},       {"+", Type::Plus},    {"-", Type::Minus},
-        {"*", Type::Mul},         {"/", Type::Slash},   {"~", Type::Tilde},
-        {"<", Type::Less},        {"=", Type::Equals},  {".", Type::Dot},
-        {",", Type::Comma},       {"@", Type::At},
-    };
-    auto it = from_str.find(str);
-    return it == from_str.end() ? Type::Unknown : it->second;
-  }
+  /// Case insensitive keyword lookup without allocations, Unknown if word is not a keyword.
+  /// true and false are keywords only if they start with a lowercase letter.
+  static constexpr Type KeywordFromString(std::string_view word) noexcept;
+
+  /// Single character punctuation lookup, Unknown if ch is not a punctuation
+  static constexpr Type PunctuatorFromChar(char ch) noexcept;
 
   static const char* ToString(Type token_type) noexcept {
     constexpr static std::array to_str{"ERROR",
@@ -100,8 +90,119 @@ struct Token {
   }
 
   Type type{Type::Unknown};
-  std::optional<std::string> lexeme{};
+  std::optional<Symbol> lexeme{};
   std::uint32_t line{0};
 };
 
+namespace detail {
+
+struct Keyword {
+  std::string_view word;
+  Token::Type type;
+};
+
+constexpr std::array<Keyword, 19> kKeywords{{
+    {"class", Token::Type::Class},   {"if", Token::Type::If},       {"else", Token::Type::Else},
+    {"then", Token::Type::Then},     {"fi", Token::Type::Fi},       {"in", Token::Type::In},
+    {"inherits", Token::Type::Inherits}, {"isvoid", Token::Type::Isvoid}, {"let", Token::Type::Let},
+    {"loop", Token::Type::Loop},     {"pool", Token::Type::Pool},   {"true", Token::Type::True},
+    {"false", Token::Type::False},   {"while", Token::Type::While}, {"case", Token::Type::Case},
+    {"esac", Token::Type::Esac},     {"new", Token::Type::New},     {"of", Token::Type::Of},
+    {"not", Token::Type::Not},
+}};
+
+constexpr std::size_t kMinKeywordSize = 2;
+constexpr std::size_t kMaxKeywordSize = 8;
+constexpr std::uint32_t kKeywordHashBits = 6;
+
+/// ASCII letters only, other identifier characters never become lowercase letters
+constexpr std::uint32_t ToLowerAscii(char ch) noexcept {
+  return static_cast<unsigned char>(ch) | 0x20u;
+}
+
+/// pre-condition: kMinKeywordSize <= word.size() <= kMaxKeywordSize
+constexpr std::uint32_t KeywordHash(std::string_view word, std::uint32_t seed) noexcept {
+  std::uint32_t key = ToLowerAscii(word[0]) | ToLowerAscii(word[1]) << 8 | ToLowerAscii(word.back()) << 16 |
+                      static_cast<std::uint32_t>(word.size()) << 24;
+  return (key * (0x9E3779B1u + 2 * seed)) >> (32 - kKeywordHashBits);
+}
+
+/// first seed without collisions among keywords, so the table below is a perfect hash
+constexpr std::uint32_t FindKeywordSeed() noexcept {
+  for (std::uint32_t seed = 0;; ++seed) {
+    std::array<bool, 1u << kKeywordHashBits> used{};
+    bool collision = false;
+    for (const auto& keyword : kKeywords) {
+      auto hash = KeywordHash(keyword.word, seed);
+      collision |= used[hash];
+      used[hash] = true;
+    }
+    if (!collision) {
+      return seed;
+    }
+  }
+}
+
+constexpr std::uint32_t kKeywordSeed = FindKeywordSeed();
+
+/// slot -> index in kKeywords + 1, zero for empty slots
+constexpr auto kKeywordTable = [] {
+  std::array<std::uint8_t, 1u << kKeywordHashBits> table{};
+  for (std::size_t i = 0; i < kKeywords.size(); ++i) {
+    table[KeywordHash(kKeywords[i].word, kKeywordSeed)] = static_cast<std::uint8_t>(i + 1);
+  }
+  return table;
+}();
+
+constexpr auto kPunctuatorTable = [] {
+  std::array<Token::Type, 256> table{};
+  constexpr std::string_view punctuators = "{}();:+-*/~<=.,@";
+  constexpr std::array types{Token::Type::LBrace, Token::Type::RBrace, Token::Type::LParen, Token::Type::RParen,
+                             Token::Type::Semicolon, Token::Type::Colon, Token::Type::Plus, Token::Type::Minus,
+                             Token::Type::Mul, Token::Type::Slash, Token::Type::Tilde, Token::Type::Less,
+                             Token::Type::Equals, Token::Type::Dot, Token::Type::Comma, Token::Type::At};
+  static_assert(punctuators.size() == types.size());
+  for (std::size_t i = 0; i < punctuators.size(); ++i) {
+    table[static_cast<unsigned char>(punctuators[i])] = types[i];
+  }
+  return table;
+}();
+
+}  // namespace detail
+
+constexpr Token::Type Token::KeywordFromString(std::string_view word) noexcept {
+  if (word.size() < detail::kMinKeywordSize || word.size() > detail::kMaxKeywordSize) {
+    return Type::Unknown;
+  }
+  auto index = detail::kKeywordTable[detail::KeywordHash(word, detail::kKeywordSeed)];
+  if (index == 0) {
+    return Type::Unknown;
+  }
+  const auto& keyword = detail::kKeywords[index - 1];
+  if (keyword.word.size() != word.size()) {
+    return Type::Unknown;
+  }
+  for (std::size_t i = 0; i < word.size(); ++i) {
+    if (detail::ToLowerAscii(word[i]) != static_cast<unsigned char>(keyword.word[i])) {
+      return Type::Unknown;
+    }
+  }
+  if ((keyword.type == Type::True || keyword.type == Type::False) && word[0] != keyword.word[0]) {
+    return Type::Unknown;
+  }
+  return keyword.type;
+}
+
+constexpr Token::Type Token::PunctuatorFromChar(char ch) noexcept {
+  return detail::kPunctuatorTable[static_cast<unsigned char>(ch)];
+}
+
+static_assert(Token::KeywordFromString("inherits") == Token::Type::Inherits);
+static_assert(Token::KeywordFromString("CLaSs") == Token::Type::Class);
+static_assert(Token::KeywordFromString("tRUE") == Token::Type::True);
+static_assert(Token::KeywordFromString("True") == Token::Type::Unknown);
+static_assert(Token::KeywordFromString("classes") == Token::Type::Unknown);
+static_assert(Token::PunctuatorFromChar('@') == Token::Type::At);
+static_assert(Token::PunctuatorFromChar('a') == Token::Type::Unknown);
+
 }  // namespace coolc
@@ -0,0 +1,222 @@
+#include "token/token_buffer.hpp"
+
+#include "symbol/symbol.hpp"
+#include "token/token.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+namespace coolc {
+
+namespace {
+
+/// tokens which keep their lexeme in place of the length
+bool HasTextLexeme(Token::Type type) {
+  return type == Token::Type::TypeID || type == Token::Type::ObjectID || type == Token::Type::Integer ||
+         type == Token::Type::String;
+}
+
+}  // namespace
+
+TokenBuffer::TokenBuffer(std::string_view source, std::shared_ptr<const std::string> storage, std::uint32_t first_line)
+    : _storage{std::move(storage)}, _source{source}, _first_line{first_line} {
+  assert(source.size() < std::numeric_limits<std::uint32_t>::max() && "source is too large");
+  _line_starts.push_back(0);
+  const char* begin = _source.data();
+  const char* end = begin + _source.size();
+  for (const char* curr = begin;
+       (curr = static_cast<const char*>(std::memchr(curr, '\n', end - curr))) != nullptr;) {
+    ++curr;
+    _line_starts.push_back(static_cast<std::uint32_t>(curr - begin));
+  }
+}
+
+void TokenBuffer::Push(Token::Type type, std::size_t begin, std::size_t end) {
+  assert(!HasTextLexeme(type) && "the lexeme of the token is missing");
+  _kinds.push_back(static_cast<std::uint8_t>(type));
+  _offsets.push_back(static_cast<std::uint32_t>(begin));
+  _lengths.push_back(static_cast<std::uint32_t>(end - begin));
+}
+
+void TokenBuffer::Push(Token::Type type, std::size_t begin, std::size_t end, Symbol lexeme) {
+  if (!HasTextLexeme(type)) {
+    _values.push_back({static_cast<std::uint32_t>(_kinds.size()), lexeme});
+    Push(type, begin, end);
+    return;
+  }
+  assert(lexeme.View().size() + (type == Token::Type::String ? 2 : 0) == end - begin);
+  _kinds.push_back(static_cast<std::uint8_t>(type));
+  _offsets.push_back(static_cast<std::uint32_t>(begin));
+  _lengths.push_back(lexeme.Id());
+}
+
+void TokenBuffer::Append(const TokenBuffer& other, std::size_t first) {
+  auto shift = static_cast<std::uint32_t>(size() - first);
+  auto values = std::lower_bound(other._values.begin(), other._values.end(), first,
+                                 [](const Value& value, std::size_t index) { return value.index < index; });
+  for (; values != other._values.end(); ++values) {
+    _values.push_back({values->index + shift, values->symbol});
+  }
+  _kinds.insert(_kinds.end(), other._kinds.begin() + first, other._kinds.end());
+  _offsets.insert(_offsets.end(), other._offsets.begin() + first, other._offsets.end());
+  _lengths.insert(_lengths.end(), other._lengths.begin() + first, other._lengths.end());
+}
+
+void TokenBuffer::Finish(std::uint32_t eof_line) {
+  Push(Token::Type::Unknown, _source.size(), _source.size());
+  _eof_line = eof_line;
+  _kinds.shrink_to_fit();
+  _offsets.shrink_to_fit();
+  _lengths.shrink_to_fit();
+  _line_starts.shrink_to_fit();
+  _values.shrink_to_fit();
+}
+
+void TokenBuffer::Splice(std::string_view source, std::size_t offset, std::size_t removed, std::size_t first,
+                         std::size_t last, const TokenBuffer& replacement, std::optional<std::uint32_t> eof_line) {
+  assert(_eof_line != 0 && last < size() && "splice of an unfinished buffer or of the end of file token");
+  auto inserted = removed + source.size() - _source.size();
+  auto delta = static_cast<std::uint32_t>(source.size() - _source.size());  // modulo 2^32
+  auto lines = _line_starts.size();
+
+  // starts of the lines after the removed newlines are replaced with starts after the inserted ones
+  auto lines_begin = std::upper_bound(_line_starts.begin(), _line_starts.end(), offset);
+  auto lines_end = std::upper_bound(lines_begin, _line_starts.end(), offset + removed);
+  std::vector<std::uint32_t> new_starts;
+  for (auto pos = source.find('\n', offset); pos < offset + inserted; pos = source.find('\n', pos + 1)) {
+    new_starts.push_back(static_cast<std::uint32_t>(pos + 1));
+  }
+  auto shifted = _line_starts.erase(lines_begin, lines_end);
+  shifted = _line_starts.insert(shifted, new_starts.begin(), new_starts.end()) + new_starts.size();
+  for (; shifted != _line_starts.end(); ++shifted) {
+    *shifted += delta;
+  }
+
+  auto added = replacement.size();
+  auto index_delta = static_cast<std::uint32_t>(added - (last - first));  // modulo 2^32
+  auto values_begin = std::lower_bound(_values.begin(), _values.end(), first,
+                                       [](const Value& value, std::size_t index) { return value.index < index; });
+  auto values_end = std::lower_bound(values_begin, _values.end(), last,
+                                     [](const Value& value, std::size_t index) { return value.index < index; });
+  for (auto it = values_end; it != _values.end(); ++it) {
+    it->index += index_delta;
+  }
+  std::vector<Value> new_values;
+  for (const auto& value : replacement._values) {
+    new_values.push_back({static_cast<std::uint32_t>(first + value.index), value.symbol});
+  }
+  _values.insert(_values.erase(values_begin, values_end), new_values.begin(), new_values.end());
+
+  auto replace = [first, last](auto& to, const auto& from) {
+    auto it = to.erase(to.begin() + first, to.begin() + last);
+    to.insert(it, from.begin(), from.end());
+  };
+  replace(_kinds, replacement._kinds);
+  replace(_offsets, replacement._offsets);
+  replace(_lengths, replacement._lengths);
+  for (auto it = _offsets.begin() + first + added; it != _offsets.end(); ++it) {
+    *it += delta;
+  }
+
+  _storage.reset();
+  _source = source;
+  _eof_line = eof_line ? *eof_line : _eof_line + static_cast<std::uint32_t>(_line_starts.size() - lines);
+}
+
+std::uint32_t TokenBuffer::Length(std::size_t index) const {
+  switch (Kind(index)) {
+    case Token::Type::TypeID:
+    case Token::Type::ObjectID:
+    case Token::Type::Integer:
+      return static_cast<std::uint32_t>(Symbol{_lengths[index]}.View().size());
+    case Token::Type::String:
+      return static_cast<std::uint32_t>(Symbol{_lengths[index]}.View().size() + 2);
+    default:
+      return _lengths[index];
+  }
+}
+
+std::uint32_t TokenBuffer::Line(std::size_t index) const {
+  if (_eof_line != 0 && index + 1 == size()) {
+    return _eof_line;
+  }
+  auto end = End(index);
+  auto starts = std::upper_bound(_line_starts.begin(), _line_starts.end(), end) - _line_starts.begin();
+  return _first_line - 1 + static_cast<std::uint32_t>(starts);
+}
+
+std::optional<Symbol> TokenBuffer::Lexeme(std::size_t index) const {
+  switch (Kind(index)) {
+    case Token::Type::TypeID:
+    case Token::Type::ObjectID:
+    case Token::Type::Integer:
+    case Token::Type::String:
+      return Symbol{_lengths[index]};
+    case Token::Type::Unknown: {
+      auto it = std::lower_bound(_values.begin(), _values.end(), index,
+                                 [](const Value& value, std::size_t index) { return value.index < index; });
+      if (it != _values.end() && it->index == index) {
+        return it->symbol;
+      }
+      return {};
+    }
+    default:
+      return {};
+  }
+}
+
+TokenBuffer::Iterator TokenBuffer::begin() const {
+  return {this, 0};
+}
+
+TokenBuffer::Iterator TokenBuffer::end() const {
+  return {this, size()};
+}
+
+TokenBuffer::Iterator TokenBuffer::At(std::size_t index) const {
+  return {this, index};
+}
+
+std::size_t TokenBuffer::MemoryUsage() const {
+  return _kinds.capacity() * sizeof(std::uint8_t) + _offsets.capacity() * sizeof(std::uint32_t) +
+         _lengths.capacity() * sizeof(std::uint32_t) + _line_starts.capacity() * sizeof(std::uint32_t) +
+         _values.capacity() * sizeof(Value);
+}
+
+TokenBuffer::Iterator::Iterator(const TokenBuffer* buffer, std::size_t index) : _buffer{buffer}, _index{index} {
+  if (index > 0 && index < buffer->size()) {
+    const auto& starts = buffer->_line_starts;
+    _line = static_cast<std::uint32_t>(std::upper_bound(starts.begin(), starts.end(), buffer->End(index)) -
+                                       starts.begin());
+  }
+  Load();
+}
+
+TokenBuffer::Iterator& TokenBuffer::Iterator::operator+=(difference_type n) {
+  _index += n;
+  Load();
+  return *this;
+}
+
+void TokenBuffer::Iterator::Load() {
+  if (_index >= _buffer->size()) {
+    _token = {};
+    return;
+  }
+  _token.type = _buffer->Kind(_index);
+  _token.lexeme = _buffer->Lexeme(_index);
+  if (_buffer->_eof_line != 0 && _index + 1 == _buffer->size()) {
+    _token.line = _buffer->_eof_line;
+    return;
+  }
+  const auto& starts = _buffer->_line_starts;
+  auto end = _buffer->End(_index);
+  while (_line < starts.size() && starts[_line] <= end) {
+    ++_line;
+  }
+  _token.line = _buffer->_first_line - 1 + _line;
+}
+
+}  // namespace coolc
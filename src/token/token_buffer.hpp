@@ -0,0 +1,162 @@
+#pragma once
+
+#include "symbol/symbol.hpp"
+#include "token/token.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace coolc {
+
+/// Struct of arrays storage for the whole token stream of one source file.
+/// A token takes 9 bytes: kind, offset of its text in the source and either the length of the text or its lexeme.
+/// Lines are computed from the offsets with the table of line starts.
+/// Identifiers, integers and strings keep the lexeme interned by the lexer in place of the length, which is the length
+/// of the lexeme, plus the quotes for strings, whose lexemes are their text without the quotes.
+/// Only errors, whose lexemes are not the text of the token, keep a Symbol in a side table.
+class TokenBuffer {
+ public:
+  class Iterator;
+
+  TokenBuffer() = default;
+
+  /// source must outlive the buffer unless storage owns it, first_line is the line of the first character
+  TokenBuffer(std::string_view source, std::shared_ptr<const std::string> storage, std::uint32_t first_line = 1);
+
+  /// [begin, end) is the text of the token in the source, pre-condition: the token has no lexeme
+  void Push(Token::Type type, std::size_t begin, std::size_t end);
+  void Push(Token::Type type, std::size_t begin, std::size_t end, Symbol lexeme);
+
+  /// Appends tokens of other starting from first, offsets of both buffers must refer to the same source
+  void Append(const TokenBuffer& other, std::size_t first);
+
+  /// Appends end of file token, no tokens may be pushed after it
+  void Finish(std::uint32_t eof_line);
+
+  /// Tokens [first, first + removed) of a buffer replaced with [first, first + inserted) by an edit
+  struct Change {
+    std::size_t first;
+    std::size_t removed;
+    std::size_t inserted;
+  };
+
+  /// Moves a finished buffer to source, which differs from the old one by removed characters at offset replaced with
+  /// new ones. Tokens [first, last) are replaced with the tokens of replacement, which has no end of file token.
+  /// Following tokens and lines are shifted, the end of file line is shifted by the change of the number of lines
+  /// unless eof_line is given. Cost is linear in the number of the shifted tokens and lines, without any scanning.
+  /// source must outlive the buffer.
+  void Splice(std::string_view source, std::size_t offset, std::size_t removed, std::size_t first, std::size_t last,
+              const TokenBuffer& replacement, std::optional<std::uint32_t> eof_line);
+
+  std::size_t size() const {
+    return _kinds.size();
+  }
+  bool empty() const {
+    return _kinds.empty();
+  }
+
+  Token::Type Kind(std::size_t index) const {
+    return static_cast<Token::Type>(_kinds[index]);
+  }
+  std::size_t Offset(std::size_t index) const {
+    return _offsets[index];
+  }
+  std::size_t End(std::size_t index) const {
+    return _offsets[index] + Length(index);
+  }
+  std::string_view Text(std::size_t index) const {
+    return _source.substr(_offsets[index], Length(index));
+  }
+  std::uint32_t Line(std::size_t index) const;
+  std::optional<Symbol> Lexeme(std::size_t index) const;
+
+  Token operator[](std::size_t index) const {
+    return {.type = Kind(index), .lexeme = Lexeme(index), .line = Line(index)};
+  }
+  Token back() const {
+    return (*this)[size() - 1];
+  }
+
+  Iterator begin() const;
+  Iterator end() const;
+  /// iterator at the token, its line is found by binary search
+  Iterator At(std::size_t index) const;
+
+  /// Heap memory owned by the buffer in bytes, the source is not counted
+  std::size_t MemoryUsage() const;
+
+ private:
+  struct Value {
+    std::uint32_t index;
+    Symbol symbol;
+  };
+
+  std::uint32_t Length(std::size_t index) const;
+
+  std::shared_ptr<const std::string> _storage;
+  std::string_view _source;
+  std::vector<std::uint8_t> _kinds;
+  std::vector<std::uint32_t> _offsets;
+  /// length of the text or id of the lexeme
+  std::vector<std::uint32_t> _lengths;
+  /// offsets of the first characters of the lines
+  std::vector<std::uint32_t> _line_starts;
+  /// sorted by index
+  std::vector<Value> _values;
+  std::uint32_t _first_line{1};
+  std::uint32_t _eof_line{0};
+};
+
+/// Forward iterator which materializes the current Token.
+/// Lines are monotonic in the stream, so advancing the iterator moves the line cursor forward in amortized O(1).
+class TokenBuffer::Iterator {
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = Token;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const Token*;
+  using reference = const Token&;
+
+  Iterator() = default;
+
+  reference operator*() const {
+    return _token;
+  }
+  pointer operator->() const {
+    return &_token;
+  }
+
+  Iterator& operator+=(difference_type n);
+  Iterator& operator++() {
+    return *this += 1;
+  }
+  Iterator operator++(int) {
+    auto copy = *this;
+    ++*this;
+    return copy;
+  }
+
+  friend bool operator==(const Iterator& lhs, const Iterator& rhs) {
+    return lhs._index == rhs._index;
+  }
+
+ private:
+  friend class TokenBuffer;
+
+  Iterator(const TokenBuffer* buffer, std::size_t index);
+
+  void Load();
+
+  const TokenBuffer* _buffer{nullptr};
+  std::size_t _index{0};
+  std::uint32_t _line{1};
+  Token _token{};
+};
+
+}  // namespace coolc
@@ -0,0 +1,46 @@
+#include "token/token_stream.hpp"
+
+#include "token/token.hpp"
+#include "token/token_buffer.hpp"
+
+namespace coolc {
+
+TokenStream::TokenStream(Producer producer) : _producer{std::move(producer)} {
+  for (auto& token : _ring) {
+    token = Pull();
+  }
+}
+
+TokenStream::TokenStream(const TokenBuffer& tokens, std::size_t first)
+    : TokenStream([it = tokens.At(first), end = tokens.end()]() mutable {
+        return it == end ? Token{} : *it++;
+      }) {
+  _previous_line = first > 0 ? tokens.Line(first - 1) : 0;
+}
+
+TokenStream& TokenStream::operator++() {
+  if (const auto& token = _ring[_head]; token.type != Token::Type::Unknown || token.lexeme) {
+    _previous_line = token.line;
+  }
+  _ring[_head] = Pull();
+  _head = (_head + 1) % kLookahead;
+  ++_consumed;
+  return *this;
+}
+
+TokenStream& TokenStream::operator+=(std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    ++*this;
+  }
+  return *this;
+}
+
+Token TokenStream::Pull() {
+  if (!_eof) {
+    _last = _producer();
+    _eof = _last.type == Token::Type::Unknown && !_last.lexeme;
+  }
+  return _last;
+}
+
+}  // namespace coolc
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "token/token.hpp"
+#include "token/token_buffer.hpp"
+
+#include <array>
+#include <cstddef>
+#include <functional>
+
+namespace coolc {
+
+/// Pull interface of the parser: a ring of the next kLookahead tokens over a producer.
+/// The producer is called only when the stream advances, so tokens are never materialized all at once.
+/// After the end of file token the stream keeps returning it.
+class TokenStream {
+ public:
+  using Producer = std::function<Token()>;
+
+  static constexpr std::size_t kLookahead = 2;
+
+  explicit TokenStream(Producer producer);
+  /// tokens must outlive the stream, which starts at the first token
+  explicit TokenStream(const TokenBuffer& tokens, std::size_t first = 0);
+
+  const Token& operator*() const {
+    return _ring[_head];
+  }
+  const Token* operator->() const {
+    return &_ring[_head];
+  }
+
+  /// pre-condition: offset < kLookahead
+  const Token& Peek(std::size_t offset) const {
+    return _ring[(_head + offset) % kLookahead];
+  }
+
+  TokenStream& operator++();
+  /// returns the token the stream was at
+  Token operator++(int) {
+    auto token = **this;
+    ++*this;
+    return token;
+  }
+  TokenStream& operator+=(std::size_t n);
+
+  /// number of tokens the stream has advanced by
+  std::size_t Consumed() const {
+    return _consumed;
+  }
+
+  /// line of the last token the stream has advanced past, 0 before the first token
+  std::size_t PreviousLine() const {
+    return _previous_line;
+  }
+
+ private:
+  Token Pull();
+
+  Producer _producer;
+  std::array<Token, kLookahead> _ring;
+  std::size_t _head{0};
+  std::size_t _consumed{0};
+  std::size_t _previous_line{0};
+  bool _eof{false};
+  Token _last{};
+};
+
+}  // namespace coolc
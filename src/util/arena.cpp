@@ -0,0 +1,30 @@
+#include "util/arena.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+
+namespace coolc::util {
+
+void* Arena::AllocateBlock(std::size_t size, std::size_t alignment) {
+  auto block_size = std::max(_next_block_size, size + alignment);
+  _next_block_size = std::min(_next_block_size * 2, kMaxBlockSize);
+  // default initialized, the memory is not zeroed
+  _blocks.emplace_back(new std::byte[block_size]);
+  _reserved += block_size;
+  _current = _blocks.back().get();
+  _end = _current + block_size;
+  return Allocate(size, alignment);
+}
+
+void Arena::Merge(Arena&& other) {
+  _blocks.insert(_blocks.end(), std::make_move_iterator(other._blocks.begin()),
+                 std::make_move_iterator(other._blocks.end()));
+  _reserved += other._reserved;
+  other._blocks.clear();
+  other._current = other._end = nullptr;
+  other._next_block_size = kFirstBlockSize;
+  other._reserved = 0;
+}
+
+}  // namespace coolc::util
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace coolc::util {
+
+/// Bump allocator: objects are placed one after another in large blocks, which are released all at once.
+/// Destructors are never run, so only trivially destructible objects may be allocated.
+class Arena {
+ public:
+  static constexpr std::size_t kFirstBlockSize = std::size_t{1} << 12;
+  static constexpr std::size_t kMaxBlockSize = std::size_t{1} << 20;
+
+  Arena() = default;
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  template <typename T, typename... Args>
+  T* New(Args&&... args) {
+    static_assert(std::is_trivially_destructible_v<T>, "destructors of arena objects are never run");
+    return ::new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+  }
+
+  /// copy of items in the arena
+  template <typename T>
+  std::span<T> NewArray(std::span<const T> items) {
+    static_assert(std::is_trivially_destructible_v<T>, "destructors of arena objects are never run");
+    if (items.empty()) {
+      return {};
+    }
+    auto* data = static_cast<T*>(Allocate(sizeof(T) * items.size(), alignof(T)));
+    std::uninitialized_copy(items.begin(), items.end(), data);
+    return {data, items.size()};
+  }
+
+  void* Allocate(std::size_t size, std::size_t alignment) {
+    auto space = static_cast<std::size_t>(_end - _current);
+    void* result = _current;
+    if (_current == nullptr || std::align(alignment, size, result, space) == nullptr) {
+      return AllocateBlock(size, alignment);
+    }
+    _current = static_cast<std::byte*>(result) + size;
+    return result;
+  }
+
+  /// Takes the blocks of other, objects allocated in it stay valid and are released with this arena
+  void Merge(Arena&& other);
+
+  /// Heap memory owned by the arena in bytes
+  std::size_t MemoryUsage() const {
+    return _reserved;
+  }
+
+ private:
+  /// starts a new block which fits size bytes aligned to alignment
+  void* AllocateBlock(std::size_t size, std::size_t alignment);
+
+  std::vector<std::unique_ptr<std::byte[]>> _blocks;
+  std::byte* _current{nullptr};
+  std::byte* _end{nullptr};
+  std::size_t _next_block_size{kFirstBlockSize};
+  std::size_t _reserved{0};
+};
+
+}  // namespace coolc::util
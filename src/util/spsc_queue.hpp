@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace coolc::util {
+
+/// Bounded lock-free queue for exactly one producer thread and one consumer thread.
+/// head is written only by the consumer and tail only by the producer, both are monotonic counters and a slot is
+/// published by the release store of tail. Each side keeps a cached copy of the other side's counter, so the shared
+/// cache line is read only when the queue looks full or empty. A blocked side sleeps in atomic wait on that counter.
+template <typename T>
+class SpscQueue {
+ public:
+  /// capacity is rounded up to a power of two
+  explicit SpscQueue(std::size_t capacity) : _slots(RoundUp(capacity)), _mask{_slots.size() - 1} {
+  }
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  /// Producer side, returns false if the queue is full
+  bool TryPush(T& value) {
+    auto tail = _tail.load(std::memory_order_relaxed);
+    if (tail - _cached_head == _slots.size()) {
+      _cached_head = _head.load(std::memory_order_acquire);
+      if (tail - _cached_head == _slots.size()) {
+        return false;
+      }
+    }
+    _slots[tail & _mask] = std::move(value);
+    _tail.store(tail + 1, std::memory_order_release);
+    _tail.notify_one();
+    return true;
+  }
+
+  /// Producer side, waits while the queue is full
+  void Push(T value) {
+    while (!TryPush(value)) {
+      _head.wait(_cached_head, std::memory_order_acquire);
+    }
+  }
+
+  /// Consumer side, nullopt if the queue is empty
+  std::optional<T> TryPop() {
+    auto head = _head.load(std::memory_order_relaxed);
+    if (head == _cached_tail) {
+      _cached_tail = _tail.load(std::memory_order_acquire);
+      if (head == _cached_tail) {
+        return std::nullopt;
+      }
+    }
+    std::optional<T> value{std::move(_slots[head & _mask])};
+    _head.store(head + 1, std::memory_order_release);
+    _head.notify_one();
+    return value;
+  }
+
+  /// Consumer side, waits while the queue is empty
+  T Pop() {
+    while (true) {
+      if (auto value = TryPop()) {
+        return std::move(*value);
+      }
+      _tail.wait(_cached_tail, std::memory_order_acquire);
+    }
+  }
+
+ private:
+  static std::size_t RoundUp(std::size_t capacity) {
+    std::size_t size = 1;
+    while (size < capacity) {
+      size *= 2;
+    }
+    return size;
+  }
+
+  static constexpr std::size_t kCacheLine = 64;
+
+  std::vector<T> _slots;
+  std::size_t _mask;
+  alignas(kCacheLine) std::atomic<std::size_t> _head{0};
+  std::size_t _cached_tail{0};
+  alignas(kCacheLine) std::atomic<std::size_t> _tail{0};
+  std::size_t _cached_head{0};
+};
+
+}  // namespace coolc::util
@@ -0,0 +1,41 @@
+#include "util/thread_pool.hpp"
+
+#include <algorithm>
+
+namespace coolc::util {
+
+ThreadPool::ThreadPool(std::size_t threads) {
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  _workers.reserve(threads);
+  for (std::size_t i = 0; i < threads; ++i) {
+    _workers.emplace_back([this] { Work(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  _pending.release(static_cast<std::ptrdiff_t>(_workers.size()));
+  for (auto& worker : _workers) {
+    worker.join();
+  }
+}
+
+void ThreadPool::Work() {
+  while (true) {
+    _pending.acquire();
+    std::function<void()> task;
+    {
+      std::lock_guard lock(_mutex);
+      // the queue is empty only after all tasks are taken and the pool is destroyed
+      if (_tasks.empty()) {
+        return;
+      }
+      task = std::move(_tasks.front());
+      _tasks.pop_front();
+    }
+    task();
+  }
+}
+
+}  // namespace coolc::util
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <semaphore>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace coolc::util {
+
+/// Fixed set of worker threads executing tasks in FIFO order.
+/// The destructor finishes all submitted tasks before joining the workers.
+/// Workers wait on a semaphore which is released once per task and once per worker at the destruction.
+class ThreadPool {
+ public:
+  /// zero means the number of hardware threads
+  explicit ThreadPool(std::size_t threads = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  std::size_t Size() const {
+    return _workers.size();
+  }
+
+  template <typename F>
+  std::future<std::invoke_result_t<F>> Submit(F task) {
+    auto packaged = std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::move(task));
+    auto result = packaged->get_future();
+    {
+      std::lock_guard lock(_mutex);
+      _tasks.emplace_back([packaged] { (*packaged)(); });
+    }
+    _pending.release();
+    return result;
+  }
+
+ private:
+  void Work();
+
+  std::vector<std::thread> _workers;
+  std::mutex _mutex;
+  std::deque<std::function<void()>> _tasks;
+  std::counting_semaphore<> _pending{0};
+};
+
+}  // namespace coolc::util
@@ -1,7 +1,520 @@
-/// TODO: implement tests
+#include "lexer/lexer.hpp"
+#include "lexer/scan.hpp"
+#include "lexer/token_pipeline.hpp"
+#include "symbol/symbol.hpp"
+#include "token/string_literal.hpp"
+#include "token/token.hpp"
+#include "token/token_buffer.hpp"
+#include "util/spsc_queue.hpp"
+#include "util/thread_pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
 
 #include <gtest/gtest.h>
 
+namespace {
+
+using coolc::Lexer;
+using coolc::Token;
+
+std::string Repeat(std::string_view pattern, std::size_t times) {
+  std::string result;
+  result.reserve(pattern.size() * times);
+  for (std::size_t i = 0; i < times; ++i) {
+    result.append(pattern);
+  }
+  return result;
+}
+
+/// minimal time of several Tokenize runs in seconds
+double MeasureTokenize(const std::string& source, std::size_t* tokens_count) {
+  double best = 0;
+  for (int i = 0; i < 3; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    *tokens_count = Lexer(std::string_view{source}).Tokenize().size();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    best = i == 0 ? elapsed.count() : std::min(best, elapsed.count());
+  }
+  return best;
+}
+
+/// all tokens up to the end of file
+std::vector<Token> Drain(Lexer* lexer) {
+  std::vector<Token> result;
+  for (auto token = lexer->NextToken(); token.type != Token::Type::Unknown || token.lexeme;
+       token = lexer->NextToken()) {
+    result.push_back(token);
+  }
+  result.push_back(lexer->NextToken());
+  return result;
+}
+
+void ExpectSameTokens(const coolc::TokenBuffer& actual, const coolc::TokenBuffer& expected, const std::string& name) {
+  ASSERT_EQ(actual.size(), expected.size()) << name;
+  for (std::size_t i = 0; i < actual.size(); ++i) {
+    ASSERT_EQ(actual.Kind(i), expected.Kind(i)) << name << ", token #" << i;
+    ASSERT_EQ(actual.Offset(i), expected.Offset(i)) << name << ", token #" << i;
+    ASSERT_EQ(actual.End(i), expected.End(i)) << name << ", token #" << i;
+    ASSERT_EQ(actual.Lexeme(i), expected.Lexeme(i)) << name << ", token #" << i;
+    ASSERT_EQ(actual.Line(i), expected.Line(i)) << name << ", token #" << i;
+  }
+}
+
+/// read end of a pipe which is filled with text by a background thread
+class PipeSource {
+ public:
+  explicit PipeSource(std::string text) {
+    int fds[2];
+    EXPECT_EQ(pipe(fds), 0);
+    _read = fds[0];
+    _writer = std::thread([text = std::move(text), fd = fds[1]] {
+      for (std::size_t written = 0; written < text.size();) {
+        auto result = write(fd, text.data() + written, text.size() - written);
+        if (result <= 0) {
+          break;
+        }
+        written += result;
+      }
+      close(fd);
+    });
+  }
+
+  ~PipeSource() {
+    _writer.join();
+    close(_read);
+  }
+
+  int Fd() const {
+    return _read;
+  }
+
+ private:
+  int _read{-1};
+  std::thread _writer;
+};
+
+std::vector<const coolc::scan::Kernels*> SimdKernels() {
+  std::vector<const coolc::scan::Kernels*> result;
+  for (const auto* kernels : {coolc::scan::Sse2Kernels(), coolc::scan::Avx2Kernels()}) {
+    if (kernels) {
+      result.push_back(kernels);
+    }
+  }
+  return result;
+}
+
+/// random text over the alphabet with long runs of the same character class
+std::string RandomText(std::mt19937* gen, std::string_view alphabet, std::size_t size) {
+  std::string result;
+  std::uniform_int_distribution<std::size_t> pick(0, alphabet.size() - 1);
+  std::uniform_int_distribution<std::size_t> run(1, 40);
+  while (result.size() < size) {
+    result.append(run(*gen), alphabet[pick(*gen)]);
+  }
+  result.resize(size);
+  return result;
+}
+
+}  // namespace
+
 TEST(Simple, Simple) {
   EXPECT_EQ(1, 1);
 }
+
+TEST(Lexer, SimpleClass) {
+  auto tokens = Lexer("class Main inherits IO {\n  x : Int <- 42;\n};").Tokenize();
+  std::vector<Token::Type> expected{
+      Token::Type::Class,  Token::Type::TypeID,    Token::Type::Inherits, Token::Type::TypeID,
+      Token::Type::LBrace, Token::Type::ObjectID,  Token::Type::Colon,    Token::Type::TypeID,
+      Token::Type::Assign, Token::Type::Integer,   Token::Type::Semicolon, Token::Type::RBrace,
+      Token::Type::Semicolon, Token::Type::Unknown};
+  ASSERT_EQ(tokens.size(), expected.size());
+  for (std::size_t i = 0; i < tokens.size(); ++i) {
+    EXPECT_EQ(tokens[i].type, expected[i]) << "token #" << i;
+  }
+  EXPECT_EQ(tokens[5].lexeme->View(), "x");
+  EXPECT_EQ(tokens[9].lexeme->View(), "42");
+  EXPECT_EQ(tokens[5].line, 2);
+  EXPECT_FALSE(tokens.back().lexeme);
+}
+
+TEST(Lexer, OwningAndViewModesAgree) {
+  std::string source = "(* nested (* comment *) *)\nx<-\"str\\ting\";--line\ntRuE FALSE";
+  auto owning = Lexer(source).Tokenize();
+  auto view = Lexer(std::string_view{source}).Tokenize();
+  ASSERT_EQ(owning.size(), view.size());
+  for (std::size_t i = 0; i < owning.size(); ++i) {
+    EXPECT_EQ(owning[i].type, view[i].type);
+    EXPECT_EQ(owning[i].lexeme, view[i].lexeme);
+    EXPECT_EQ(owning[i].line, view[i].line);
+  }
+  EXPECT_EQ(owning[2].type, Token::Type::String);
+  EXPECT_EQ(owning[4].type, Token::Type::True);
+  EXPECT_EQ(owning[5].type, Token::Type::TypeID);
+  EXPECT_EQ(owning[5].line, 3);
+}
+
+TEST(TokenBuffer, MatchesNextToken) {
+  std::string source =
+      "class A { s : String <- \"multi\\\nline\\t\"; };\n(* comment\n*) x <- 1 + 2 # $ \"bad\nstr\" 123abc"
+      " ~isvoid\n\n*) \"unterminated -- line comment at EOF";
+  auto tokens = Lexer(std::string_view{source}).Tokenize();
+  Lexer lexer(std::string_view{source});
+  std::size_t index = 0;
+  for (const auto& token : tokens) {
+    auto expected = lexer.NextToken();
+    ASSERT_LT(index, tokens.size());
+    EXPECT_EQ(token.type, expected.type) << "token #" << index;
+    EXPECT_EQ(token.lexeme, expected.lexeme) << "token #" << index;
+    EXPECT_EQ(token.line, expected.line) << "token #" << index;
+    EXPECT_EQ(tokens[index].line, expected.line) << "token #" << index;
+    ++index;
+  }
+  EXPECT_EQ(index, tokens.size());
+  EXPECT_EQ(tokens.Kind(3), Token::Type::ObjectID);
+  EXPECT_EQ(tokens.Text(3), "s");
+  EXPECT_EQ(tokens[7].lexeme->View(), "multi\\\nline\\t");
+  EXPECT_EQ(coolc::EscapeStringLiteral(tokens[7].lexeme->View()), "multi\\nline\\t");
+  EXPECT_EQ(tokens[7].line, 2);
+}
+
+TEST(TokenBuffer, FiveTimesSmallerThanTokenVector) {
+  // layout of the token before the buffer: type, lexeme and line in every token
+  struct StringToken {
+    Token::Type type;
+    std::optional<std::string> lexeme;
+    std::uint32_t line;
+  };
+  auto source = Repeat("class Main inherits IO {\n  main() : Object { out_string(\"hello\") };\n};\n", 1 << 12);
+  auto tokens = Lexer(std::string_view{source}).Tokenize();
+  EXPECT_LE(tokens.MemoryUsage() * 5, tokens.size() * sizeof(StringToken));
+}
+
+TEST(TokenBuffer, KeepsLexemesInternedByTheLexer) {
+  std::string source = "class Main { s : String <- \"a\\tb\"; n : Int <- 12345; };";
+  auto tokens = Lexer(std::string_view{source}).Tokenize();
+  auto symbols = coolc::SymbolTable::Instance().Size();
+  for (std::size_t i = 0; i + 1 < tokens.size(); ++i) {
+    auto text = tokens.Text(i);
+    EXPECT_EQ(text, std::string_view{source}.substr(tokens.Offset(i), tokens.End(i) - tokens.Offset(i)));
+    if (auto lexeme = tokens.Lexeme(i); lexeme) {
+      EXPECT_EQ(lexeme->View(), tokens.Kind(i) == Token::Type::String ? coolc::StringLiteralContent(text) : text);
+    }
+  }
+  // the lexemes are read from the buffer, not interned again
+  EXPECT_EQ(coolc::SymbolTable::Instance().Size(), symbols);
+  EXPECT_EQ(tokens.Lexeme(7)->View(), "a\\tb");
+  EXPECT_EQ(tokens.Text(13), "12345");
+}
+
+TEST(Lexer, StreamingMatchesWholeSource) {
+  std::string source =
+      "class A inherits IO { s : String <- \"multi\\\nline\\t\"; f(x : Int) : Int { x <= 1 <- 2 => 3 };};\n"
+      "(* nested (* comment *)\n*) identifier_with_digits_123 <- 1234567 # \"bad\nstr\" 123abc *)"
+      " ~isvoid\n\n\"long string literal crossing chunks\" (* unterminated -- line comment";
+  Lexer whole(std::string_view{source});
+  auto expected = Drain(&whole);
+  for (std::size_t chunk_size : {1, 2, 3, 7, 64, 1 << 16}) {
+    PipeSource pipe(source);
+    auto lexer = Lexer::FromFileDescriptor(pipe.Fd(), chunk_size);
+    auto tokens = Drain(&lexer);
+    ASSERT_EQ(tokens.size(), expected.size()) << "chunk size " << chunk_size;
+    for (std::size_t i = 0; i < tokens.size(); ++i) {
+      EXPECT_EQ(tokens[i].type, expected[i].type) << "token #" << i << ", chunk size " << chunk_size;
+      EXPECT_EQ(tokens[i].lexeme, expected[i].lexeme) << "token #" << i << ", chunk size " << chunk_size;
+      EXPECT_EQ(tokens[i].line, expected[i].line) << "token #" << i << ", chunk size " << chunk_size;
+    }
+  }
+}
+
+TEST(Lexer, StreamingTokenizeRest) {
+  auto source = Repeat("x <- \"a\";\n-- comment\n", 1000);
+  PipeSource pipe(source);
+  auto lexer = Lexer::FromFileDescriptor(pipe.Fd(), 16);
+  for (int i = 0; i < 4 * 500; ++i) {
+    lexer.NextToken();
+  }
+  auto tokens = lexer.Tokenize();
+  ASSERT_EQ(tokens.size(), 4 * 500 + 1);
+  EXPECT_EQ(tokens[0].type, Token::Type::ObjectID);
+  EXPECT_EQ(tokens[0].line, 1001);
+  EXPECT_EQ(tokens[2].lexeme->View(), "a");
+  EXPECT_EQ(tokens.back().line, 2001);
+}
+
+TEST(SpscQueue, TransfersInOrderAcrossThreads) {
+  coolc::util::SpscQueue<std::size_t> queue(4);
+  constexpr std::size_t kCount = 100000;
+  std::thread producer([&] {
+    for (std::size_t i = 0; i < kCount; ++i) {
+      queue.Push(i);
+    }
+  });
+  for (std::size_t i = 0; i < kCount; ++i) {
+    ASSERT_EQ(queue.Pop(), i);
+  }
+  producer.join();
+  EXPECT_FALSE(queue.TryPop());
+}
+
+TEST(TokenPipeline, MatchesSerialOnCorpus) {
+  std::size_t files = 0;
+  for (const auto& entry : std::filesystem::directory_iterator(COOLC_E2E_DIR "/lexer")) {
+    if (entry.path().extension() != ".cl") {
+      continue;
+    }
+    std::ifstream is(entry.path(), std::ios::binary);
+    std::string source{std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>()};
+    Lexer serial(std::string_view{source});
+    auto expected = Drain(&serial);
+    // tiny batches and queues make both sides block
+    for (std::size_t batch_size : {1, 3, 1024}) {
+      Lexer lexer(std::string_view{source});
+      coolc::TokenPipeline pipeline(lexer, batch_size, 2);
+      auto stream = pipeline.Stream();
+      for (std::size_t i = 0; i < expected.size(); ++i, ++stream) {
+        ASSERT_EQ(stream->type, expected[i].type) << entry.path() << " token #" << i;
+        ASSERT_EQ(stream->lexeme, expected[i].lexeme) << entry.path() << " token #" << i;
+        ASSERT_EQ(stream->line, expected[i].line) << entry.path() << " token #" << i;
+      }
+      EXPECT_EQ(stream->type, Token::Type::Unknown);
+      EXPECT_FALSE(stream->lexeme);
+    }
+    ++files;
+  }
+  EXPECT_GT(files, 50u);
+}
+
+TEST(TokenPipeline, StopsWhenConsumerLeavesEarly) {
+  auto source = Repeat("x <- \"a\";\n", 100000);
+  Lexer lexer(std::string_view{source});
+  {
+    coolc::TokenPipeline pipeline(lexer, 16, 2);
+    auto stream = pipeline.Stream();
+    stream += 10;
+    EXPECT_EQ(stream->type, Token::Type::String);
+  }
+  // the lexer was stopped long before the end of the source
+  EXPECT_NE(lexer.NextToken().type, Token::Type::Unknown);
+}
+
+TEST(Lexer, ParallelMatchesSerialOnCorpus) {
+  coolc::util::ThreadPool pool(4);
+  std::size_t files = 0;
+  for (const auto& entry : std::filesystem::directory_iterator(COOLC_E2E_DIR "/lexer")) {
+    if (entry.path().extension() != ".cl") {
+      continue;
+    }
+    std::ifstream is(entry.path(), std::ios::binary);
+    std::string source{std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>()};
+    auto expected = Lexer(std::string_view{source}).Tokenize();
+    // tiny chunks put boundaries inside of strings, comments and tokens
+    for (std::size_t chunk_size : {1, 7, 64}) {
+      auto tokens = Lexer(std::string_view{source}).Tokenize(pool, chunk_size);
+      ExpectSameTokens(tokens, expected, entry.path().filename().string() + " / " + std::to_string(chunk_size));
+    }
+    ++files;
+  }
+  EXPECT_GT(files, 50u);
+}
+
+TEST(Lexer, ParallelMatchesSerialOnRandomSources) {
+  coolc::util::ThreadPool pool(8);
+  std::mt19937 gen(7);
+  constexpr std::string_view alphabet = " \n\n\t\"\"\\(**)-- ab1<=>-;:\0@#";
+  for (int i = 0; i < 300; ++i) {
+    auto source = RandomText(&gen, alphabet, 1 + i * 7);
+    std::shuffle(source.begin(), source.end(), gen);
+    auto expected = Lexer(std::string_view{source}).Tokenize();
+    auto tokens = Lexer(std::string_view{source}).Tokenize(pool, 1 + i % 13);
+    ExpectSameTokens(tokens, expected, "random #" + std::to_string(i));
+  }
+}
+
+TEST(Lexer, RelexMatchesTokenizeAfterRandomEdits) {
+  std::mt19937 gen(11);
+  constexpr std::string_view alphabet = " \n\t\"\\(**)-- ab1<=>-;:@#";
+  for (const auto& entry : std::filesystem::directory_iterator(COOLC_E2E_DIR "/lexer")) {
+    if (entry.path().extension() != ".cl") {
+      continue;
+    }
+    std::ifstream is(entry.path(), std::ios::binary);
+    std::string source{std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>()};
+    auto tokens = Lexer(std::string_view{source}).Tokenize();
+    // every version of the text must be alive while the buffer refers to it
+    std::deque<std::string> versions;
+    for (int i = 0; i < 20; ++i) {
+      std::uniform_int_distribution<std::size_t> offset_dist(0, source.size());
+      auto offset = offset_dist(gen);
+      std::uniform_int_distribution<std::size_t> removed_dist(0, std::min<std::size_t>(source.size() - offset, 8));
+      auto removed = removed_dist(gen);
+      auto inserted = RandomText(&gen, alphabet, std::uniform_int_distribution<std::size_t>(0, 6)(gen));
+      source.replace(offset, removed, inserted);
+      versions.push_back(source);
+
+      std::string_view text = versions.back();
+      Lexer::Relex(&tokens, text, {offset, removed, text.substr(offset, inserted.size())});
+      auto expected = Lexer(std::string_view{versions.back()}).Tokenize();
+      ExpectSameTokens(tokens, expected, entry.path().filename().string() + " / edit #" + std::to_string(i));
+    }
+  }
+}
+
+TEST(Lexer, RelexIsLocal) {
+  auto source = Repeat("class A {\n  f(x : Int) : Int { x + 1 };\n};\n", 1000);
+  auto tokens = Lexer(std::string_view{source}).Tokenize();
+  auto middle = source.size() / 2;
+  auto offset = source.find("x + 1", middle);
+
+  // rename an identifier
+  auto renamed = source;
+  renamed.replace(offset, 1, "xyz");
+  auto change = Lexer::Relex(&tokens, renamed, {offset, 1, "xyz"});
+  EXPECT_EQ(change.removed, 1u);
+  EXPECT_EQ(change.inserted, 1u);
+  EXPECT_EQ(tokens.End(change.first), offset + 3);
+  ExpectSameTokens(tokens, Lexer(std::string_view{renamed}).Tokenize(), "rename");
+
+  // an opened string lasts until the end of the line
+  auto quoted = renamed;
+  quoted.insert(offset, 1, '"');
+  EXPECT_LE(Lexer::Relex(&tokens, quoted, {offset, 0, "\""}).inserted, 3u);
+  ExpectSameTokens(tokens, Lexer(std::string_view{quoted}).Tokenize(), "string");
+
+  // a line is commented out by closing the comment first and then opening it
+  auto line_end = quoted.find('\n', offset);
+  auto closed = quoted;
+  closed.insert(line_end, "*)");
+  EXPECT_LE(Lexer::Relex(&tokens, closed, {line_end, 0, "*)"}).inserted, 2u);
+  ExpectSameTokens(tokens, Lexer(std::string_view{closed}).Tokenize(), "close comment");
+  auto line_start = closed.rfind('\n', offset) + 1;
+  auto commented = closed;
+  commented.insert(line_start, "(*");
+  EXPECT_LE(Lexer::Relex(&tokens, commented, {line_start, 0, "(*"}).inserted, 1u);
+  ExpectSameTokens(tokens, Lexer(std::string_view{commented}).Tokenize(), "open comment");
+
+  // a comment which is not closed damages the rest of the file
+  auto unclosed = commented;
+  unclosed.insert(0, "(*");
+  EXPECT_EQ(Lexer::Relex(&tokens, unclosed, {0, 0, "(*"}).inserted, 1u);
+  ExpectSameTokens(tokens, Lexer(std::string_view{unclosed}).Tokenize(), "unclosed comment");
+}
+
+TEST(Lexer, MultiMegabyteInputIsLinear) {
+  // no whitespace at all: the worst case for word based scanners
+  constexpr std::string_view pattern = "a+bb*(ccc-1)<-dddd;(*x(*y*)*)\"s\\n\";Type.f(x,y)@Z--c\n";
+  constexpr std::size_t tokens_in_pattern = 24;
+  constexpr std::size_t small_times = 1 << 13;
+  constexpr std::size_t scale = 8;
+
+  auto small = Repeat(pattern, small_times);
+  auto large = Repeat(pattern, small_times * scale);
+  ASSERT_GT(large.size(), 3u << 20);
+
+  std::size_t small_tokens = 0;
+  std::size_t large_tokens = 0;
+  auto small_time = MeasureTokenize(small, &small_tokens);
+  auto large_time = MeasureTokenize(large, &large_tokens);
+
+  EXPECT_EQ(small_tokens, tokens_in_pattern * small_times + 1);
+  EXPECT_EQ(large_tokens, tokens_in_pattern * small_times * scale + 1);
+  // linear lexer grows ~8x, quadratic one would grow ~64x
+  EXPECT_LT(large_time, small_time * scale * 3);
+}
+
+TEST(Scan, SimdKernelsMatchScalar) {
+  const auto& scalar = coolc::scan::ScalarKernels();
+  std::mt19937 gen(42);
+  constexpr std::string_view alphabet = " \t\n\v\f\r\x08\x0e\x80" "azAZ09_@[`{/:()*x\"\\";
+  for (const auto* kernels : SimdKernels()) {
+    for (std::size_t size = 0; size < 300; ++size) {
+      auto text = RandomText(&gen, alphabet, size);
+      auto begin = text.data();
+      auto end = text.data() + text.size();
+      for (std::size_t offset = 0; offset <= std::min<std::size_t>(size, 40); ++offset) {
+        std::uint32_t expected_lines = 0;
+        std::uint32_t lines = 0;
+        EXPECT_EQ(kernels->skip_whitespace(begin + offset, end, &lines),
+                  scalar.skip_whitespace(begin + offset, end, &expected_lines))
+            << kernels->name;
+        EXPECT_EQ(lines, expected_lines) << kernels->name;
+        EXPECT_EQ(kernels->find_word_end(begin + offset, end), scalar.find_word_end(begin + offset, end))
+            << kernels->name;
+        EXPECT_EQ(kernels->find_comment_delimiter(begin + offset, end),
+                  scalar.find_comment_delimiter(begin + offset, end))
+            << kernels->name;
+        EXPECT_EQ(kernels->find_string_special(begin + offset, end), scalar.find_string_special(begin + offset, end))
+            << kernels->name;
+      }
+    }
+  }
+}
+
+TEST(Scan, ScalarKernels) {
+  const auto& scalar = coolc::scan::ScalarKernels();
+  std::string_view text = " \t\n\r\n  abc_1Z+ (** *)\n";
+  std::uint32_t lines = 0;
+  auto word = scalar.skip_whitespace(text.data(), text.data() + text.size(), &lines);
+  EXPECT_EQ(word - text.data(), 7);
+  EXPECT_EQ(lines, 2);
+  EXPECT_EQ(*scalar.find_word_end(word, text.data() + text.size()), '+');
+  auto comment = scalar.find_comment_delimiter(word, text.data() + text.size());
+  EXPECT_EQ(std::string_view(comment, 2), "(*");
+  comment = scalar.find_comment_delimiter(comment + 2, text.data() + text.size());
+  EXPECT_EQ(std::string_view(comment, 2), "*)");
+  EXPECT_EQ(*scalar.find_comment_delimiter(comment + 2, text.data() + text.size()), '\n');
+
+  constexpr std::string_view string{"ab \\t\"cd\n\0", 10};
+  auto special = scalar.find_string_special(string.data(), string.data() + string.size());
+  EXPECT_EQ(*special, '\\');
+  special = scalar.find_string_special(special + 1, string.data() + string.size());
+  EXPECT_EQ(*special, '"');
+  special = scalar.find_string_special(special + 1, string.data() + string.size());
+  EXPECT_EQ(*special, '\n');
+  EXPECT_EQ(*scalar.find_string_special(special + 1, string.data() + string.size()), '\0');
+}
+
+TEST(Lexer, StringLiteralsAreRawSlices) {
+  std::string_view source = "\"a\\tb\\\"c\\\nd\te\\\\\" \"\"";
+  auto tokens = Lexer(source).Tokenize();
+  ASSERT_EQ(tokens.size(), 3u);
+  EXPECT_EQ(tokens[0].lexeme->View(), source.substr(1, source.find(' ') - 2));
+  EXPECT_EQ(coolc::DecodeStringLiteral(tokens[0].lexeme->View()), "a\tb\"c\nd\te\\");
+  EXPECT_EQ(coolc::EscapeStringLiteral(tokens[0].lexeme->View()), "a\\tb\\\"c\\nd\\te\\\\");
+  EXPECT_EQ(tokens[1].lexeme->View(), "");
+
+  // the length limit is counted after escape sequences are joined
+  std::string longest = '"' + std::string(1020, 'a') + "\\t\\t\\t\\t\"";
+  EXPECT_EQ(Lexer(longest).NextToken().type, Token::Type::String);
+  auto too_long = Lexer(longest.insert(1, 1, 'a')).NextToken();
+  EXPECT_EQ(too_long.type, Token::Type::Unknown);
+  EXPECT_EQ(too_long.lexeme->View(), "String constant too long");
+}
+
+TEST(Scan, CommentHeavySourceLines) {
+  // newlines inside of nested comments must be counted exactly
+  std::string source;
+  for (int i = 0; i < 100; ++i) {
+    source += "(* line\n (* nested *) ***** ( * ) \n*)\n   \n";
+  }
+  source += "x";
+  auto tokens = Lexer(std::string_view{source}).Tokenize();
+  ASSERT_EQ(tokens.size(), 2u);
+  EXPECT_EQ(tokens[0].type, Token::Type::ObjectID);
+  EXPECT_EQ(tokens[0].line, 401);
+}
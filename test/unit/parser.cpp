@@ -1,7 +1,620 @@
 /// TODO: implement tests
 
+#include "ast/ast_cache.hpp"
+#include "ast/expression.hpp"
+#include "ast/flat_ast.hpp"
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+#include "util/arena.hpp"
+#include "util/thread_pool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
 #include <gtest/gtest.h>
 
+#include <unistd.h>
+
+namespace {
+
+constexpr std::string_view kProgram = R"(
+class Main inherits IO {
+  x : Int <- 1 + 2 * 3;
+  main() : Object {{
+    out_string("hello\n");
+    let y : Int <- x in while y < 10 loop y <- y + 1 pool;
+    if not x = 2 then self@IO.out_int(x).out_string(" ") else case x of i : Int => i; esac fi;
+  }};
+};
+)";
+
+std::string Print(const coolc::Program& program) {
+  testing::internal::CaptureStdout();
+  coolc::PrintProgram(program);
+  return testing::internal::GetCapturedStdout();
+}
+
+std::string ReadFile(const std::filesystem::path& path) {
+  std::ifstream is(path, std::ios::binary);
+  return {std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>()};
+}
+
+}  // namespace
+
 TEST(Simple, Simple) {
   EXPECT_EQ(1, 1);
 }
+
+TEST(Parser, StreamingMatchesTokenBuffer) {
+  coolc::Lexer buffered_lexer(kProgram);
+  auto tokens = buffered_lexer.Tokenize();
+  auto expected = Print(coolc::Parser(tokens, "test.cl").ParseProgram());
+
+  coolc::Lexer lexer(kProgram);
+  auto actual = Print(coolc::Parser(lexer.Stream(), "test.cl").ParseProgram());
+  EXPECT_EQ(actual, expected);
+  EXPECT_NE(actual.find("_dispatch"), std::string::npos);
+}
+
+TEST(Parser, ExpressionsLiveInProgramArena) {
+  auto tokens = coolc::Lexer(kProgram).Tokenize();
+  auto program = coolc::Parser(tokens, "test.cl").ParseProgram();
+  auto expected = Print(program);
+  ASSERT_NE(program.arena, nullptr);
+  EXPECT_GT(program.arena->MemoryUsage(), 0u);
+
+  // children point into the arena, so moving the program keeps the tree intact
+  auto moved = std::move(program);
+  EXPECT_EQ(Print(moved), expected);
+
+  const auto& main = std::get<coolc::Method>(moved.classes[0].features[1].feature);
+  const auto* block = main.expr->As<coolc::Block>();
+  ASSERT_NE(block, nullptr);
+  ASSERT_EQ(block->expr.size(), 3u);
+  // nodes are bump allocated in the order they are completed
+  EXPECT_LT(block->expr[0], block->expr[1]);
+  EXPECT_LT(block->expr[1], block->expr[2]);
+}
+
+TEST(Arena, AlignedBumpAllocation) {
+  coolc::util::Arena arena;
+  auto* byte = arena.New<char>('x');
+  auto* number = arena.New<std::uint64_t>(42);
+  EXPECT_EQ(*byte, 'x');
+  EXPECT_EQ(*number, 42u);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(number) % alignof(std::uint64_t), 0u);
+  EXPECT_LT(reinterpret_cast<char*>(number) - byte, 16);
+
+  std::vector<int> items{1, 2, 3};
+  auto copy = arena.NewArray<int>(items);
+  EXPECT_TRUE(std::equal(copy.begin(), copy.end(), items.begin(), items.end()));
+  EXPECT_TRUE(arena.NewArray<int>({}).empty());
+
+  // allocations larger than a block get a block of their own
+  auto* large = arena.Allocate(coolc::util::Arena::kMaxBlockSize * 2, 64);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(large) % 64, 0u);
+  EXPECT_GE(arena.MemoryUsage(), coolc::util::Arena::kMaxBlockSize * 2);
+}
+
+TEST(FlatAst, RoundTripOnParserCorpus) {
+  std::size_t files = 0;
+  for (const auto& entry : std::filesystem::directory_iterator(COOLC_E2E_DIR "/parser")) {
+    auto path = entry.path();
+    // parse errors terminate the parser
+    if (path.extension() != ".cl" || ReadFile(path.replace_extension(".out")).starts_with("\"")) {
+      continue;
+    }
+    auto source = ReadFile(entry.path());
+    auto tokens = coolc::Lexer(std::string_view{source}).Tokenize();
+    auto program = coolc::Parser(tokens, "test.cl").ParseProgram();
+    auto ast = coolc::FlatAst::FromProgram(program);
+    EXPECT_EQ(Print(ast.ToProgram()), Print(program)) << entry.path();
+
+    // post-order: operands of a node precede it
+    for (coolc::FlatAst::Index i = 0; i < ast.Nodes().size(); ++i) {
+      const auto& node = ast[i];
+      if (node.kind == coolc::FlatAst::Kind::While || (node.kind >= coolc::FlatAst::Kind::Plus &&
+                                                       node.kind <= coolc::FlatAst::Kind::Equal)) {
+        EXPECT_LT(node.lhs, i);
+        EXPECT_LT(node.rhs, i);
+      }
+    }
+    ++files;
+  }
+  EXPECT_GT(files, 30u);
+}
+
+TEST(FlatAst, NodesAreSmallerThanExpressions) {
+  auto tokens = coolc::Lexer(kProgram).Tokenize();
+  auto program = coolc::Parser(tokens, "test.cl").ParseProgram();
+  auto ast = coolc::FlatAst::FromProgram(program);
+  EXPECT_GT(ast.Nodes().size(), 30u);
+  // a node with its type against a node of the tree, without the side arrays of either
+  EXPECT_LE((sizeof(coolc::FlatAst::Node) + sizeof(coolc::Symbol)) * 3, sizeof(coolc::Expression));
+}
+
+TEST(FlatAst, DeepTreesDoNotRecurse) {
+  // deep enough to overflow the stack of a recursive walk
+  constexpr std::size_t kDepth = 100000;
+  std::string sum = "1";
+  for (std::size_t i = 0; i < kDepth; ++i) {
+    sum += " + 1";
+  }
+  auto source = "class Main { f() : Int { " + sum + " }; g() : Int { " + std::string(kDepth, '~') + "1 }; };";
+  auto tokens = coolc::Lexer(std::string_view{source}).Tokenize();
+  auto program = coolc::Parser(tokens, "test.cl").ParseProgram();
+  auto ast = coolc::FlatAst::FromProgram(program);
+  EXPECT_EQ(ast.Nodes().size(), 3 * kDepth + 2);
+  auto loaded = coolc::FlatAst::Deserialize(ast.Serialize(1), 1);
+  ASSERT_TRUE(loaded);
+  auto expanded = loaded->ToProgram();
+
+  const auto* expr = std::get<coolc::Method>(expanded.classes[0].features[0].feature).expr;
+  for (std::size_t i = 0; i < kDepth; ++i) {
+    const auto* plus = expr->As<coolc::Plus>();
+    ASSERT_NE(plus, nullptr) << i;
+    ASSERT_TRUE(plus->rhs->Is<coolc::Int>()) << i;
+    expr = plus->lhs;
+  }
+  EXPECT_TRUE(expr->Is<coolc::Int>());
+  expr = std::get<coolc::Method>(expanded.classes[0].features[1].feature).expr;
+  for (std::size_t i = 0; i < kDepth; ++i) {
+    const auto* inversion = expr->As<coolc::Inversion>();
+    ASSERT_NE(inversion, nullptr) << i;
+    expr = inversion->arg;
+  }
+  EXPECT_TRUE(expr->Is<coolc::Int>());
+}
+
+TEST(FlatAst, ImageRejectsOtherSourcesAndDamage) {
+  auto tokens = coolc::Lexer(kProgram).Tokenize();
+  auto program = coolc::Parser(tokens, "test.cl").ParseProgram();
+  auto image = coolc::FlatAst::FromProgram(program).Serialize(1);
+
+  auto loaded = coolc::FlatAst::Deserialize(image, 1);
+  ASSERT_TRUE(loaded);
+  EXPECT_EQ(Print(loaded->ToProgram()), Print(program));
+  EXPECT_EQ(loaded->Serialize(1), image);
+  EXPECT_EQ(coolc::FlatAst::FromProgram(program).Serialize(1), image);
+
+  EXPECT_FALSE(coolc::FlatAst::Deserialize(image, 2));
+  EXPECT_FALSE(coolc::FlatAst::Deserialize("", 1));
+  for (std::size_t size = 0; size < image.size(); size += 7) {
+    EXPECT_FALSE(coolc::FlatAst::Deserialize(std::string_view{image}.substr(0, size), 1)) << size;
+  }
+  auto other_version = image;
+  ++other_version[8];
+  EXPECT_FALSE(coolc::FlatAst::Deserialize(other_version, 1));
+}
+
+TEST(FlatAst, ImageWithFlippedBytesIsRejectedOrWellFormed) {
+  auto tokens = coolc::Lexer(kProgram).Tokenize();
+  auto program = coolc::Parser(tokens, "test.cl").ParseProgram();
+  auto image = coolc::FlatAst::FromProgram(program).Serialize(1);
+  std::size_t rejected = 0;
+  for (std::size_t i = 0; i < image.size(); ++i) {
+    for (char mask : {'\x01', '\x80', '\xff'}) {
+      auto damaged = image;
+      damaged[i] ^= mask;
+      auto loaded = coolc::FlatAst::Deserialize(damaged, 1);
+      if (!loaded) {
+        ++rejected;
+        continue;
+      }
+      // an accepted image has every index in bounds, so it can be expanded and printed
+      Print(loaded->ToProgram());
+    }
+  }
+  EXPECT_GT(rejected, image.size());
+}
+
+TEST(AstCache, HitsOnlyForUnchangedSource) {
+  auto directory = std::filesystem::temp_directory_path() / ("coolc_ast_cache_" + std::to_string(::getpid()));
+  std::filesystem::remove_all(directory);
+  coolc::AstCache cache{directory};
+  std::string source{kProgram};
+  EXPECT_FALSE(cache.Load("test.cl", source));
+
+  auto tokens = coolc::Lexer(std::string_view{source}).Tokenize();
+  auto program = coolc::Parser(tokens, "test.cl").ParseProgram();
+  cache.Store("test.cl", source, program);
+  auto loaded = cache.Load("test.cl", source);
+  ASSERT_TRUE(loaded);
+  EXPECT_EQ(Print(*loaded), Print(program));
+
+  EXPECT_FALSE(cache.Load("other.cl", source));
+  source += "\n";
+  EXPECT_FALSE(cache.Load("test.cl", source));
+  std::filesystem::remove_all(directory);
+}
+
+TEST(Parser, DeepNestingDoesNotRecurse) {
+  // deep enough to overflow the stack of a recursive descent
+  constexpr std::size_t kDepth = 200000;
+  std::string body;
+  for (std::size_t i = 0; i < kDepth; ++i) {
+    body += "x <- not ~(";
+  }
+  body += "1 + 2 * 3";
+  body += std::string(kDepth, ')');
+  auto source = "class Main { f() : Int { " + body + " }; };";
+  auto tokens = coolc::Lexer(std::string_view{source}).Tokenize();
+  auto program = coolc::Parser(tokens, "test.cl").ParseProgram();
+
+  // the tree is walked iteratively, printing it would recurse
+  const auto* expr = std::get<coolc::Method>(program.classes[0].features[0].feature).expr;
+  for (std::size_t i = 0; i < kDepth; ++i) {
+    const auto* assign = expr->As<coolc::Assign>();
+    ASSERT_NE(assign, nullptr) << i;
+    const auto* negation = assign->rhs->As<coolc::Not>();
+    ASSERT_NE(negation, nullptr) << i;
+    const auto* inversion = negation->arg->As<coolc::Inversion>();
+    ASSERT_NE(inversion, nullptr) << i;
+    expr = inversion->arg;
+  }
+  const auto* sum = expr->As<coolc::Plus>();
+  ASSERT_NE(sum, nullptr);
+  EXPECT_TRUE(sum->rhs->Is<coolc::Mul>());
+}
+
+TEST(Parser, DeepCompoundsDoNotRecurse) {
+  // deep enough to overflow the stack of a recursive descent
+  constexpr std::size_t kDepth = 100000;
+  auto nested = [](std::string_view open, std::string_view inner, std::string_view close) {
+    std::string body;
+    for (std::size_t i = 0; i < kDepth; ++i) {
+      body += open;
+    }
+    body += inner;
+    for (std::size_t i = 0; i < kDepth; ++i) {
+      body += close;
+    }
+    return "class Main {\n  f(x : Int) : Object { " + body + " };\n  g() : Int { 1 };\n};\n";
+  };
+  auto parse = [](const std::string& source) {
+    auto tokens = coolc::Lexer(std::string_view{source}).Tokenize();
+    coolc::Parser parser(tokens, "test.cl", coolc::Parser::ErrorMode::Recover);
+    auto program = parser.ParseProgram();
+    return std::pair{std::move(program), parser.Diagnostics().size()};
+  };
+  auto body = [](const coolc::Program& program) {
+    return std::get<coolc::Method>(program.classes[0].features[0].feature).expr;
+  };
+
+  struct Nesting {
+    std::string_view open;
+    std::string_view close;
+    /// the nested expression which contains the next level
+    const coolc::Expression* (*inner)(const coolc::Expression*);
+  };
+  const std::array<Nesting, 6> nestings{{
+      {"if true then ", " else 0 fi",
+       [](const coolc::Expression* expr) -> const coolc::Expression* { return expr->As<coolc::If>()->then_expr; }},
+      {"while true loop ", " pool",
+       [](const coolc::Expression* expr) -> const coolc::Expression* { return expr->As<coolc::While>()->loop_body; }},
+      {"let y : Int <- ", " in y",
+       [](const coolc::Expression* expr) -> const coolc::Expression* { return expr->As<coolc::Let>()->attrs[0].expr; }},
+      {"{ ", "; }",
+       [](const coolc::Expression* expr) -> const coolc::Expression* { return expr->As<coolc::Block>()->expr[0]; }},
+      {"case ", " of y : Int => y; esac",
+       [](const coolc::Expression* expr) -> const coolc::Expression* { return expr->As<coolc::Case>()->expr; }},
+      {"f(", ")",
+       [](const coolc::Expression* expr) -> const coolc::Expression* {
+         return expr->As<coolc::Dispatch>()->parameters[0];
+       }},
+  }};
+  for (const auto& nesting : nestings) {
+    auto [program, errors] = parse(nested(nesting.open, "0", nesting.close));
+    EXPECT_EQ(errors, 0u) << nesting.open;
+    ASSERT_EQ(program.classes[0].features.size(), 2u) << nesting.open;
+    // the tree is walked iteratively, printing it would recurse
+    const auto* expr = body(program);
+    for (std::size_t i = 0; i < kDepth; ++i) {
+      expr = nesting.inner(expr);
+    }
+    EXPECT_TRUE(expr->Is<coolc::Int>()) << nesting.open;
+  }
+
+  // the innermost block recovers from an error deep inside, the blocks around it keep their expressions
+  auto [blocks, block_errors] = parse(nested("{ ", "1 +", "; }"));
+  EXPECT_EQ(block_errors, 1u);
+  ASSERT_EQ(blocks.classes[0].features.size(), 2u);
+  const auto* block = body(blocks)->As<coolc::Block>();
+  for (std::size_t i = 1; i < kDepth; ++i) {
+    ASSERT_EQ(block->expr.size(), 1u) << i;
+    block = block->expr[0]->As<coolc::Block>();
+  }
+  EXPECT_TRUE(block->expr.empty());
+
+  // without a block the error drops the method, the parser recovers at its ';'
+  auto [conditions, condition_errors] = parse(nested("if true then ", "1 +", " else 0 fi"));
+  EXPECT_EQ(condition_errors, 1u);
+  ASSERT_EQ(conditions.classes[0].features.size(), 1u);
+  EXPECT_EQ(std::get<coolc::Method>(conditions.classes[0].features[0].feature).object_id,
+            coolc::Symbol::Intern("g"));
+}
+
+TEST(Parser, ParallelMatchesSerial) {
+  coolc::util::ThreadPool pool(4);
+  std::size_t files = 0;
+  for (const auto& entry : std::filesystem::directory_iterator(COOLC_E2E_DIR "/parser")) {
+    auto path = entry.path();
+    if (path.extension() != ".cl" || ReadFile(path.replace_extension(".out")).starts_with("\"")) {
+      continue;
+    }
+    auto source = ReadFile(entry.path());
+    auto tokens = coolc::Lexer(std::string_view{source}).Tokenize();
+    auto expected = Print(coolc::Parser(tokens, "test.cl").ParseProgram());
+    EXPECT_EQ(Print(coolc::Parser(tokens, "test.cl").ParseProgram(pool, 1)), expected) << entry.path();
+    ++files;
+  }
+  EXPECT_GT(files, 30u);
+
+  // a string literal is a single token, its braces and keywords do not move the class boundaries
+  std::string source;
+  for (int i = 0; i < 200; ++i) {
+    source += "class C" + std::to_string(i) + " inherits IO {\n  f(x : Int) : Object {{ out_string(\"class {\");";
+    source += " if x < " + std::to_string(i) + " then x + 1 else x * 2 fi; }};\n};\n";
+  }
+  auto tokens = coolc::Lexer(std::string_view{source}).Tokenize();
+  auto expected = Print(coolc::Parser(tokens, "test.cl").ParseProgram());
+  for (std::size_t min_classes : {1, 7, 64, 1000}) {
+    auto program = coolc::Parser(tokens, "test.cl").ParseProgram(pool, min_classes);
+    EXPECT_EQ(program.classes.size(), 200u);
+    EXPECT_EQ(Print(program), expected) << min_classes;
+  }
+}
+
+TEST(Parser, ParallelReportsFirstError) {
+  std::string source;
+  for (int i = 0; i < 100; ++i) {
+    source += "class C" + std::to_string(i) + " {\n";
+    // errors at lines 152 and 242, in the classes of different chunks
+    source += i == 50 || i == 80 ? "  x : Int <- ;\n" : "  x : Int <- 1;\n";
+    source += "};\n";
+  }
+  auto tokens = coolc::Lexer(std::string_view{source}).Tokenize();
+  // the test starts threads, so the death test process is executed from scratch instead of forked
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  coolc::util::ThreadPool pool(4);
+  EXPECT_EXIT(coolc::Parser(tokens, "test.cl").ParseProgram(pool, 1), testing::ExitedWithCode(1),
+              "test.cl, line 152\n");
+}
+
+TEST(Parser, RecoversFromSyntaxErrors) {
+  constexpr std::string_view kSource = R"(class A {
+  x : int;
+  f() : Int { { 1; A; 2; } };
+  g() : Int { 1 + };
+  y : Bool;
+};
+class B inherits {
+  z : Int;
+};
+class C {};
+)";
+  auto tokens = coolc::Lexer(kSource).Tokenize();
+  coolc::Parser parser(tokens, "test.cl", coolc::Parser::ErrorMode::Recover);
+  auto program = parser.ParseProgram();
+
+  std::vector<std::pair<std::size_t, std::string>> diagnostics;
+  for (const auto& diagnostic : parser.Diagnostics()) {
+    diagnostics.emplace_back(diagnostic.line, diagnostic.near);
+  }
+  std::vector<std::pair<std::size_t, std::string>> expected{
+      {2, "OBJECTID = int"}, {3, "TYPEID = A"}, {4, "'}'"}, {7, "'{'"}};
+  EXPECT_EQ(diagnostics, expected);
+
+  // classes and features with errors are dropped, a block keeps its valid expressions
+  ASSERT_EQ(program.classes.size(), 2u);
+  EXPECT_EQ(program.classes[0].type, coolc::Symbol::Intern("A"));
+  EXPECT_EQ(program.classes[1].type, coolc::Symbol::Intern("C"));
+  const auto& features = program.classes[0].features;
+  ASSERT_EQ(features.size(), 2u);
+  const auto& method = std::get<coolc::Method>(features[0].feature);
+  EXPECT_EQ(method.object_id, coolc::Symbol::Intern("f"));
+  EXPECT_EQ(method.expr->As<coolc::Block>()->expr.size(), 2u);
+  EXPECT_EQ(std::get<coolc::Attribute>(features[1].feature).object_id, coolc::Symbol::Intern("y"));
+
+  testing::internal::CaptureStderr();
+  parser.PrintDiagnostics(std::cerr);
+  auto printed = testing::internal::GetCapturedStderr();
+  EXPECT_TRUE(printed.starts_with("\"test.cl\", line 2: syntax error at or near OBJECTID = int\n")) << printed;
+
+  // as in the reference parser: errors cascading from a recovered one are not reported, a recovery skips to the next
+  // ';' even inside braces, and the end of file is reported at the line of the last token
+  for (std::string_view name : {"classbadname", "emptyprogram", "casenoexpr", "badfeatures"}) {
+    auto path = std::filesystem::path{COOLC_E2E_DIR "/parser"} / name;
+    auto source = ReadFile(path.replace_extension(".cl"));
+    auto expected = ReadFile(path.replace_extension(".out"));
+    expected.erase(expected.find("Compilation halted"));
+    auto file_tokens = coolc::Lexer(std::string_view{source}).Tokenize();
+    auto filename = "test/e2e/parser/" + std::string{name} + ".cl";
+    coolc::Parser file_parser(file_tokens, filename, coolc::Parser::ErrorMode::Recover);
+    file_parser.ParseProgram();
+    std::ostringstream os;
+    file_parser.PrintDiagnostics(os);
+    EXPECT_EQ(os.str(), expected) << name;
+  }
+
+  // a dispatch without a method name after its dot is an error at the token after the dot
+  auto missing_name = coolc::Lexer(std::string_view{"class Main {\n  f() : Int { {\n  a.;\n  a@T.;\n  3; } };\n};\n"})
+                          .Tokenize();
+  coolc::Parser missing_name_parser(missing_name, "test.cl", coolc::Parser::ErrorMode::Recover);
+  auto recovered = missing_name_parser.ParseProgram();
+  diagnostics.clear();
+  for (const auto& diagnostic : missing_name_parser.Diagnostics()) {
+    diagnostics.emplace_back(diagnostic.line, diagnostic.near);
+  }
+  expected = {{3, "';'"}, {4, "';'"}};
+  EXPECT_EQ(diagnostics, expected);
+  ASSERT_EQ(recovered.classes.size(), 1u);
+  ASSERT_EQ(recovered.classes[0].features.size(), 1u);
+  const auto& block = std::get<coolc::Method>(recovered.classes[0].features[0].feature).expr->As<coolc::Block>();
+  ASSERT_NE(block, nullptr);
+  EXPECT_EQ(block->expr.size(), 1u);
+}
+
+TEST(Parser, ParallelRecoversLikeSerial) {
+  std::string source;
+  for (int i = 0; i < 120; ++i) {
+    source += "class C" + std::to_string(i) + " {\n";
+    switch (i % 7) {
+      case 1:
+        source += "  x : Int <- ;\n";
+        break;
+      case 3:
+        // the next class starts inside the braces of this one
+        source += "  f() : Int { {\n";
+        break;
+      case 5:
+        source += "  g() : Int { 1 };\n}; };\n";
+        break;
+      default:
+        source += "  x : Int <- 1;\n";
+    }
+    source += "};\n";
+  }
+  auto tokens = coolc::Lexer(std::string_view{source}).Tokenize();
+  coolc::Parser serial(tokens, "test.cl", coolc::Parser::ErrorMode::Recover);
+  auto expected = Print(serial.ParseProgram());
+  ASSERT_FALSE(serial.Diagnostics().empty());
+
+  coolc::util::ThreadPool pool(4);
+  for (std::size_t min_classes : {1, 5, 1000}) {
+    coolc::Parser parser(tokens, "test.cl", coolc::Parser::ErrorMode::Recover);
+    EXPECT_EQ(Print(parser.ParseProgram(pool, min_classes)), expected) << min_classes;
+    ASSERT_EQ(parser.Diagnostics().size(), serial.Diagnostics().size()) << min_classes;
+    for (std::size_t i = 0; i < serial.Diagnostics().size(); ++i) {
+      EXPECT_EQ(parser.Diagnostics()[i].line, serial.Diagnostics()[i].line) << i;
+      EXPECT_EQ(parser.Diagnostics()[i].near, serial.Diagnostics()[i].near) << i;
+    }
+  }
+}
+
+TEST(Parser, ParallelDiagnosticsMatchSerial) {
+  // a recovery at the end of a chunk keeps the next errors quiet in the next chunk, as in the serial parse
+  std::vector<std::string> sources{
+      "class A { };\nc class lass A { };\nclass (  A { x : Int <- 1; f(x : I } nt) : Int { x + 1 }; };\n"};
+  constexpr std::array<std::string_view, 24> kWords{"class", "class", "class", "A", "B",  "inherits", "{",  "}",
+                                                    "{",     "}",     ";",     ";", "(",  ")",        ":",  "x",
+                                                    "Int",   "<-",    "1",     "+", "if", "fi",       "let", "in"};
+  constexpr std::array<std::string_view, 4> kFragments{
+      "class A { x : Int <- 1; };\n", "class B inherits A { f(x : Int) : Int { { x; x + 1; } }; };\n",
+      "f(x : Int) : Int { x + 1 };\n", "class C { g() : Object { if x then 1 else 2 fi }; };\n"};
+  std::mt19937 random{17};
+  for (int i = 0; i < 1000; ++i) {
+    std::string source{"class"};
+    for (auto parts = 1 + random() % 12; parts > 0; --parts) {
+      if (random() % 2 == 0) {
+        source += kFragments[random() % kFragments.size()];
+      } else {
+        for (auto words = 1 + random() % 6; words > 0; --words) {
+          source += ' ';
+          source += kWords[random() % kWords.size()];
+        }
+        source += '\n';
+      }
+    }
+    sources.push_back(std::move(source));
+  }
+
+  auto diagnostics = [](const coolc::Parser& parser) {
+    std::vector<std::pair<std::size_t, std::string>> res;
+    for (const auto& diagnostic : parser.Diagnostics()) {
+      res.emplace_back(diagnostic.line, diagnostic.near);
+    }
+    return res;
+  };
+  coolc::util::ThreadPool pool(4);
+  for (const auto& source : sources) {
+    auto tokens = coolc::Lexer(std::string_view{source}).Tokenize();
+    coolc::Parser serial(tokens, "test.cl", coolc::Parser::ErrorMode::Recover);
+    auto expected = Print(serial.ParseProgram());
+    coolc::Parser parallel(tokens, "test.cl", coolc::Parser::ErrorMode::Recover);
+    EXPECT_EQ(Print(parallel.ParseProgram(pool, 1)), expected) << source;
+    EXPECT_EQ(diagnostics(parallel), diagnostics(serial)) << source;
+  }
+}
+
+TEST(Parser, ReparseReusesUnchangedSubtrees) {
+  std::string source;
+  for (int i = 0; i < 50; ++i) {
+    source += "class C" + std::to_string(i) + " {\n  f(x : Int) : Int { x + 1 };\n  g() : Int { 2 };\n};\n";
+  }
+  auto tokens = coolc::Lexer(std::string_view{source}).Tokenize();
+  coolc::Parser parser(tokens, "test.cl");
+  auto program = parser.ParseProgram();
+  auto body = [&program](std::size_t cl, std::size_t feature) {
+    return std::get<coolc::Method>(program.classes[cl].features[feature].feature).expr;
+  };
+  auto first = body(0, 0);
+  auto last = body(40, 0);
+  auto edited = body(20, 0);
+  auto sibling = body(20, 1);
+
+  // the edit adds lines, so the classes after it are moved down
+  auto edited_source = source;
+  auto offset = edited_source.find("x + 1", edited_source.find("class C20 "));
+  edited_source.replace(offset, 5, "x +\n\n 100");
+  auto change = coolc::Lexer::Relex(&tokens, edited_source, {offset, 5, "x +\n\n 100"});
+  program = parser.Reparse(std::move(program), change);
+
+  auto expected = coolc::Lexer(std::string_view{edited_source}).Tokenize();
+  EXPECT_EQ(Print(program), Print(coolc::Parser(expected, "test.cl").ParseProgram()));
+  EXPECT_EQ(body(0, 0), first);
+  EXPECT_EQ(body(40, 0), last);
+  EXPECT_EQ(body(20, 1), sibling);
+  EXPECT_NE(body(20, 0), edited);
+}
+
+TEST(Parser, ReparseMatchesParseAfterRandomEdits) {
+  std::mt19937 gen(5);
+  constexpr std::array<std::string_view, 16> kFragments{
+      " ", "\n", ";", "{", "}", "(", ")", "x", "1 + ", "class A { ", "};", "\"", "(*", "*)", "-- ", "<- "};
+  std::size_t files = 0;
+  for (const auto& entry : std::filesystem::directory_iterator(COOLC_E2E_DIR "/parser")) {
+    if (entry.path().extension() != ".cl" || ++files > 25) {
+      continue;
+    }
+    auto source = ReadFile(entry.path());
+    auto tokens = coolc::Lexer(std::string_view{source}).Tokenize();
+    coolc::Parser parser(tokens, "test.cl", coolc::Parser::ErrorMode::Recover);
+    auto program = parser.ParseProgram();
+    // every version of the text must be alive while the buffer refers to it
+    std::deque<std::string> versions;
+    for (int i = 0; i < 20; ++i) {
+      auto offset = std::uniform_int_distribution<std::size_t>(0, source.size())(gen);
+      auto removed =
+          std::uniform_int_distribution<std::size_t>(0, std::min<std::size_t>(source.size() - offset, 6))(gen);
+      auto inserted = kFragments[std::uniform_int_distribution<std::size_t>(0, kFragments.size() - 1)(gen)];
+      source.replace(offset, removed, inserted);
+      std::string_view text = versions.emplace_back(source);
+      auto change = coolc::Lexer::Relex(&tokens, text, {offset, removed, text.substr(offset, inserted.size())});
+      program = parser.Reparse(std::move(program), change);
+
+      auto fresh_tokens = coolc::Lexer(text).Tokenize();
+      coolc::Parser fresh(fresh_tokens, "test.cl", coolc::Parser::ErrorMode::Recover);
+      auto name = entry.path().filename().string() + " / edit #" + std::to_string(i);
+      EXPECT_EQ(Print(program), Print(fresh.ParseProgram())) << name;
+      ASSERT_EQ(parser.Diagnostics().size(), fresh.Diagnostics().size()) << name;
+      for (std::size_t j = 0; j < fresh.Diagnostics().size(); ++j) {
+        EXPECT_EQ(parser.Diagnostics()[j].line, fresh.Diagnostics()[j].line) << name;
+        EXPECT_EQ(parser.Diagnostics()[j].near, fresh.Diagnostics()[j].near) << name;
+      }
+    }
+  }
+}
@@ -1,7 +1,510 @@
 /// TODO: implement tests
 
+#include "ast/expression.hpp"
+#include "ast/flat_ast.hpp"
+#include "gen/program_generator.hpp"
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+#include "semant/inheritance_graph.hpp"
+#include "semant/local_table.hpp"
+#include "semant/semant.hpp"
+#include "util/thread_pool.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
 #include <gtest/gtest.h>
 
+namespace {
+
+std::string ReadFile(const std::filesystem::path& path) {
+  std::ifstream is(path, std::ios::binary);
+  return {std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>()};
+}
+
+std::string Print(const coolc::Program& program) {
+  testing::internal::CaptureStdout();
+  coolc::PrintProgram(program);
+  return testing::internal::GetCapturedStdout();
+}
+
+/// parses and checks the source, false on any error
+bool Compiles(const std::string& source) {
+  auto tokens = coolc::Lexer(std::string_view{source}).Tokenize();
+  coolc::Parser parser(tokens, "gen.cl", coolc::Parser::ErrorMode::Recover);
+  auto program = parser.ParseProgram();
+  if (!parser.Diagnostics().empty()) {
+    return false;
+  }
+  testing::internal::CaptureStderr();
+  bool checked = coolc::Semant(std::move(program)).CheckProgram();
+  testing::internal::GetCapturedStderr();
+  return checked;
+}
+
+std::string Generate(const coolc::gen::Options& options) {
+  std::ostringstream os;
+  coolc::gen::ProgramGenerator(options).Generate(os);
+  return os.str();
+}
+
+/// classes H<i> inheriting H<parents[i]>, or Object for a negative parent, and Main
+coolc::Program Hierarchy(const std::vector<int>& parents) {
+  coolc::Program program;
+  for (std::size_t i = 0; i < parents.size(); ++i) {
+    coolc::Class cl;
+    cl.type = coolc::Symbol::Intern("H" + std::to_string(i));
+    cl.inherits_type =
+        parents[i] < 0 ? coolc::symbols::kObject : coolc::Symbol::Intern("H" + std::to_string(parents[i]));
+    program.classes.push_back(std::move(cl));
+  }
+  coolc::Class main;
+  main.type = coolc::symbols::kMain;
+  main.inherits_type = coolc::symbols::kIO;
+  program.classes.push_back(std::move(main));
+  return program;
+}
+
+}  // namespace
+
 TEST(Simple, Simple) {
   EXPECT_EQ(1, 1);
 }
+
+TEST(FlatAst, KeepsInferredTypes) {
+  std::size_t files = 0;
+  for (const auto& entry : std::filesystem::directory_iterator(COOLC_E2E_DIR "/semant")) {
+    auto path = entry.path();
+    // only programs without errors are printed with types
+    if (path.extension() != ".cl" || !ReadFile(path.replace_extension(".out")).starts_with("#")) {
+      continue;
+    }
+    auto source = ReadFile(entry.path());
+    auto tokens = coolc::Lexer(std::string_view{source}).Tokenize();
+    coolc::Semant semant(coolc::Parser(tokens, "test.cl").ParseProgram());
+    ASSERT_TRUE(semant.CheckProgram()) << entry.path();
+    auto expected = Print(semant.GetProgram());
+
+    auto ast = coolc::FlatAst::FromProgram(semant.GetProgram());
+    EXPECT_EQ(Print(ast.ToProgram()), expected) << entry.path();
+
+    auto image = ast.Serialize(42);
+    auto loaded = coolc::FlatAst::Deserialize(image, 42);
+    ASSERT_TRUE(loaded) << entry.path();
+    EXPECT_EQ(Print(loaded->ToProgram()), expected) << entry.path();
+    ++files;
+  }
+  EXPECT_GT(files, 30u);
+}
+
+TEST(ProgramGenerator, ProgramsAreTypeCorrect) {
+  coolc::gen::Options options;
+  options.classes = 24;
+  for (std::uint64_t seed = 1; seed <= 8; ++seed) {
+    options.seed = seed;
+    options.fanout = seed % 4;
+    options.inheritance_depth = seed;
+    options.expression_depth = 2 + seed % 4;
+    auto source = Generate(options);
+    EXPECT_TRUE(Compiles(source)) << "seed " << seed;
+    EXPECT_EQ(Generate(options), source) << "seed " << seed;
+  }
+}
+
+TEST(ProgramGenerator, GrowsToRequestedSize) {
+  coolc::gen::Options options;
+  options.classes = 1;
+  options.min_bytes = 1 << 18;
+  auto source = Generate(options);
+  EXPECT_GE(source.size(), options.min_bytes);
+  EXPECT_TRUE(Compiles(source));
+}
+
+TEST(ProgramGenerator, InjectedErrorsAreReported) {
+  coolc::gen::Options options;
+  options.classes = 8;
+  options.error_every = 8;
+  for (auto kind : {coolc::gen::ErrorKind::Syntax, coolc::gen::ErrorKind::Semantic, coolc::gen::ErrorKind::Mixed}) {
+    options.errors = kind;
+    for (std::uint64_t seed = 1; seed <= 8; ++seed) {
+      options.seed = seed;
+      EXPECT_FALSE(Compiles(Generate(options))) << "seed " << seed;
+    }
+  }
+}
+
+TEST(InheritanceGraph, QueriesMatchParentWalk) {
+  std::mt19937 random{7};
+  for (std::size_t size : {1, 2, 10, 300}) {
+    std::vector<int> parents(size);
+    for (std::size_t i = 0; i < size; ++i) {
+      parents[i] = static_cast<int>(random() % (i + 1)) - 1;
+    }
+    auto program = Hierarchy(parents);
+    coolc::InheritanceGraph graph;
+    ASSERT_TRUE(graph.FillAndCheck(program));
+
+    std::vector<coolc::Symbol> names;
+    for (const auto& cl : program.classes) {
+      names.push_back(cl.type);
+    }
+    names.insert(names.end(), {coolc::symbols::kObject, coolc::symbols::kIO, coolc::symbols::kInt});
+    auto chain = [&](coolc::Symbol cl) {
+      std::vector<coolc::Symbol> result{cl};
+      while (cl != coolc::symbols::kObject) {
+        cl = graph.GetAncessor(cl);
+        result.push_back(cl);
+      }
+      return result;
+    };
+    for (auto base : names) {
+      EXPECT_EQ(graph.Depth(base) + 1, chain(base).size());
+      for (auto derived : names) {
+        auto derived_chain = chain(derived);
+        EXPECT_EQ(graph.IsAncessor(base, derived),
+                  std::find(derived_chain.begin(), derived_chain.end(), base) != derived_chain.end());
+        auto base_chain = chain(base);
+        auto lca = *std::find_if(derived_chain.begin(), derived_chain.end(), [&](coolc::Symbol cl) {
+          return std::find(base_chain.begin(), base_chain.end(), cl) != base_chain.end();
+        });
+        EXPECT_EQ(graph.GetLca(base, derived), lca) << base << " " << derived;
+      }
+    }
+    EXPECT_TRUE(graph.IsAncessor(coolc::symbols::kInt, coolc::symbols::kSelfType));
+    EXPECT_FALSE(graph.IsAncessor(coolc::Symbol::Intern("Undefined"), coolc::symbols::kMain));
+    EXPECT_THROW(graph.GetLca(coolc::Symbol::Intern("Undefined"), coolc::symbols::kMain), std::out_of_range);
+  }
+}
+
+TEST(InheritanceGraph, DeepChain) {
+  constexpr int kDepth = 2000;
+  std::vector<int> parents(kDepth);
+  for (int i = 0; i < kDepth; ++i) {
+    parents[i] = i - 1;
+  }
+  auto program = Hierarchy(parents);
+  coolc::InheritanceGraph graph;
+  ASSERT_TRUE(graph.FillAndCheck(program));
+  auto top = coolc::Symbol::Intern("H0");
+  auto bottom = coolc::Symbol::Intern("H" + std::to_string(kDepth - 1));
+  auto middle = coolc::Symbol::Intern("H" + std::to_string(kDepth / 2));
+  EXPECT_EQ(graph.Depth(bottom), static_cast<std::size_t>(kDepth));
+  EXPECT_TRUE(graph.IsAncessor(top, bottom));
+  EXPECT_FALSE(graph.IsAncessor(bottom, top));
+  EXPECT_EQ(graph.GetLca(bottom, middle), middle);
+  EXPECT_EQ(graph.GetLca(coolc::symbols::kMain, bottom), coolc::symbols::kObject);
+}
+
+TEST(ClassLayouts, InheritedSlotsKeepTheirIndices) {
+  std::string source =
+      "class C inherits B { c : Int; g() : Int { 2 }; copy() : SELF_TYPE { self }; };\n"
+      "class B inherits A { b : String; f() : Int { 1 }; h() : Bool { true }; };\n"
+      "class A { a : Int; f() : Int { 0 }; g() : Int { 0 }; };\n"
+      "class Main inherits IO { main() : Object { 0 }; };\n";
+  auto tokens = coolc::Lexer(std::string_view{source}).Tokenize();
+  coolc::Semant semant(coolc::Parser(tokens, "layout.cl").ParseProgram());
+  ASSERT_TRUE(semant.CheckProgram());
+
+  const auto& layouts = semant.GetLayouts();
+  std::vector<coolc::Symbol> chain;
+  for (auto name : {"Object", "A", "B", "C"}) {
+    chain.push_back(coolc::Symbol::Intern(name));
+  }
+  for (std::size_t k = 1; k < chain.size(); ++k) {
+    auto parent = layouts.Methods(chain[k - 1]);
+    auto child = layouts.Methods(chain[k]);
+    ASSERT_LE(parent.size(), child.size());
+    for (std::size_t i = 0; i < parent.size(); ++i) {
+      EXPECT_EQ(parent[i]->name, child[i]->name);
+      EXPECT_EQ(child[i]->slot, i);
+    }
+    auto parent_attributes = layouts.Attributes(chain[k - 1]);
+    auto child_attributes = layouts.Attributes(chain[k]);
+    ASSERT_LE(parent_attributes.size(), child_attributes.size());
+    for (std::size_t i = 0; i < parent_attributes.size(); ++i) {
+      EXPECT_EQ(parent_attributes[i], child_attributes[i]);
+    }
+  }
+  auto c = chain.back();
+  auto methods = layouts.Methods(c);
+  ASSERT_EQ(methods.size(), 6u);
+  EXPECT_EQ(layouts.FindMethod(c, coolc::Symbol::Intern("f"))->owner, coolc::Symbol::Intern("B"));
+  EXPECT_EQ(layouts.FindMethod(c, coolc::Symbol::Intern("g"))->owner, coolc::Symbol::Intern("C"));
+  EXPECT_EQ(layouts.FindMethod(c, coolc::symbols::kCopy), methods[2]);
+  EXPECT_EQ(methods[2]->owner, c);
+  EXPECT_EQ(layouts.FindMethod(coolc::Symbol::Intern("A"), coolc::symbols::kCopy)->owner, coolc::symbols::kObject);
+  EXPECT_EQ(layouts.FindMethod(coolc::Symbol::Intern("A"), coolc::Symbol::Intern("h")), nullptr);
+  auto attributes = layouts.Attributes(c);
+  ASSERT_EQ(attributes.size(), 3u);
+  EXPECT_EQ(attributes[2]->name, coolc::Symbol::Intern("c"));
+  EXPECT_EQ(layouts.FindAttribute(coolc::Symbol::Intern("A"), coolc::Symbol::Intern("b")), nullptr);
+  EXPECT_EQ(layouts.FindMethod(coolc::Symbol::Intern("Undefined"), coolc::Symbol::Intern("f")), nullptr);
+}
+
+TEST(ClassLayouts, SiblingDeclarationsAreNotSeen) {
+  std::string source =
+      "class A { f() : Int { 0 }; };\n"
+      "class B inherits A { f() : Int { 1 }; x : Int; };\n"
+      "class B2 inherits B { f() : Int { 2 }; };\n"
+      "class B3 inherits B { };\n"
+      "class C inherits A { y : Int <- f(); };\n"
+      "class Main { main() : Object { 0 }; };\n";
+  auto tokens = coolc::Lexer(std::string_view{source}).Tokenize();
+  coolc::Semant semant(coolc::Parser(tokens, "layout.cl").ParseProgram());
+  ASSERT_TRUE(semant.CheckProgram());
+  const auto& layouts = semant.GetLayouts();
+  auto c = coolc::Symbol::Intern("C");
+  EXPECT_EQ(layouts.FindMethod(c, coolc::Symbol::Intern("f"))->owner, coolc::Symbol::Intern("A"));
+  EXPECT_EQ(layouts.FindAttribute(c, coolc::Symbol::Intern("x")), nullptr);
+  EXPECT_EQ(layouts.FindMethod(coolc::Symbol::Intern("B2"), coolc::Symbol::Intern("f"))->owner,
+            coolc::Symbol::Intern("B2"));
+  EXPECT_EQ(layouts.FindMethod(coolc::Symbol::Intern("B3"), coolc::Symbol::Intern("f"))->owner,
+            coolc::Symbol::Intern("B"));
+}
+
+TEST(ClassLayouts, DeepChainWithFeaturesInEveryClass) {
+  // every class adds an attribute and a method and overrides f, a copy of the inherited tables per class would be
+  // quadratic in the depth
+  constexpr int kDepth = 20000;
+  std::string source = "class H0 { a0 : Int; f() : Int { a0 }; };\n";
+  for (int i = 1; i < kDepth; ++i) {
+    auto index = std::to_string(i);
+    auto previous = std::to_string(i - 1);
+    source += "class H" + index + " inherits H" + previous + " { a" + index + " : Int <- a" + previous + "; m" +
+              index + "(x : Int) : Int { x + a0 }; f() : Int { m" + index + "(a" + previous + ") }; };\n";
+  }
+  source += "class Main { main() : Int { (new H" + std::to_string(kDepth - 1) + ").f() }; };\n";
+  auto tokens = coolc::Lexer(std::string_view{source}).Tokenize();
+  coolc::Semant semant(coolc::Parser(tokens, "deep.cl").ParseProgram());
+  ASSERT_TRUE(semant.CheckProgram());
+  auto last = coolc::Symbol::Intern("H" + std::to_string(kDepth - 1));
+  auto methods = semant.GetLayouts().Methods(last);
+  ASSERT_EQ(methods.size(), 3u + kDepth);
+  EXPECT_EQ(methods[3]->owner, last);
+  EXPECT_EQ(semant.GetLayouts().Attributes(last).size(), static_cast<std::size_t>(kDepth));
+}
+
+TEST(ClassLayouts, RedefinitionsAreFoundInAnyClassOrder) {
+  // the subclass comes first, its parent is still laid out before it
+  EXPECT_FALSE(Compiles("class B inherits A { f() : String { \"\" }; };\nclass A { f() : Int { 0 }; };\n"
+                        "class Main { main() : Object { 0 }; };\n"));
+  EXPECT_FALSE(Compiles("class B inherits A { a : Int; };\nclass A { a : Int; };\n"
+                        "class Main { main() : Object { 0 }; };\n"));
+  EXPECT_FALSE(Compiles("class A { f() : Int { 0 }; f() : Int { 1 }; };\nclass Main { main() : Object { 0 }; };\n"));
+  EXPECT_TRUE(Compiles("class B inherits A { f() : Int { 1 }; };\nclass A { f() : Int { 0 }; };\n"
+                       "class Main { main() : Object { (new B).f() }; };\n"));
+}
+
+TEST(Semant, ParallelCheckMatchesSerial) {
+  coolc::util::ThreadPool pool(4);
+  auto check = [&](const std::string& source, bool parallel) {
+    auto tokens = coolc::Lexer(std::string_view{source}).Tokenize();
+    coolc::Semant semant(coolc::Parser(tokens, "gen.cl").ParseProgram());
+    testing::internal::CaptureStdout();
+    testing::internal::CaptureStderr();
+    bool checked = false;
+    std::string exception;
+    try {
+      checked = parallel ? semant.CheckProgram(pool, 1) : semant.CheckProgram();
+    } catch (const std::out_of_range& e) {
+      exception = e.what();
+    }
+    auto out = testing::internal::GetCapturedStdout();
+    auto err = testing::internal::GetCapturedStderr();
+    if (checked) {
+      out += Print(semant.GetProgram());
+    }
+    return std::make_tuple(checked, out, err, exception);
+  };
+
+  coolc::gen::Options options;
+  options.classes = 40;
+  options.errors = coolc::gen::ErrorKind::Semantic;
+  for (std::uint64_t seed = 1; seed <= 6; ++seed) {
+    options.seed = seed;
+    // a correct program, then errors in several classes, only the first one is reported
+    options.error_every = seed % 2 == 0 ? 0 : 9 + seed;
+    auto source = Generate(options);
+    auto serial = check(source, false);
+    EXPECT_EQ(check(source, true), serial) << "seed " << seed;
+    EXPECT_EQ(std::get<0>(serial), options.error_every == 0) << "seed " << seed;
+  }
+  for (const auto& entry : std::filesystem::directory_iterator(COOLC_E2E_DIR "/semant")) {
+    if (entry.path().extension() == ".cl") {
+      auto source = ReadFile(entry.path());
+      EXPECT_EQ(check(source, true), check(source, false)) << entry.path();
+    }
+  }
+
+  // GetLca throws for the undefined type of an attribute, which only matters when no earlier class has failed
+  auto classes = [](std::size_t type_error, std::size_t undefined_type) {
+    std::string source;
+    for (std::size_t i = 0; i < 300; ++i) {
+      source += "class C" + std::to_string(i) + " {\n";
+      if (i == type_error) {
+        source += "  f() : Int { \"no\" };\n";
+      }
+      if (i == undefined_type) {
+        source += "  x : Foo <- 1;\n";
+      }
+      source += "};\n";
+    }
+    return source + "class Main { main() : Int { 0 }; };\n";
+  };
+  for (auto source : {classes(5, 250), classes(300, 250), classes(250, 5)}) {
+    auto serial = check(source, false);
+    EXPECT_FALSE(std::get<0>(serial));
+    EXPECT_EQ(check(source, true), serial);
+  }
+  EXPECT_TRUE(std::get<3>(check(classes(300, 250), true)).find("Foo") != std::string::npos);
+  EXPECT_TRUE(std::get<3>(check(classes(5, 250), true)).empty());
+}
+
+TEST(LocalTable, MatchesStackOfMaps) {
+  std::mt19937 random{3};
+  std::vector<coolc::Symbol> names;
+  for (int i = 0; i < 200; ++i) {
+    names.push_back(coolc::Symbol::Intern("local" + std::to_string(i)));
+  }
+  coolc::LocalTable table;
+  std::vector<std::vector<std::pair<coolc::Symbol, coolc::Symbol>>> reference;
+  auto find = [&](coolc::Symbol name) -> std::optional<coolc::Symbol> {
+    for (auto scope = reference.rbegin(); scope != reference.rend(); ++scope) {
+      for (const auto& [bound, type] : *scope) {
+        if (bound == name) {
+          return type;
+        }
+      }
+    }
+    return std::nullopt;
+  };
+  for (int step = 0; step < 20000; ++step) {
+    auto name = names[random() % names.size()];
+    auto choice = random() % 8;
+    if (reference.empty() || (choice == 0 && reference.size() < 300)) {
+      table.Enter();
+      reference.emplace_back();
+    } else if (choice == 1) {
+      table.Leave();
+      reference.pop_back();
+    } else if (choice < 5) {
+      auto type = names[random() % names.size()];
+      bool fresh = std::find_if(reference.back().begin(), reference.back().end(),
+                                [&](const auto& binding) { return binding.first == name; }) == reference.back().end();
+      ASSERT_EQ(table.Bind(name, type), fresh);
+      if (fresh) {
+        reference.back().emplace_back(name, type);
+      }
+    }
+    ASSERT_EQ(table.Find(name), find(name)) << "step " << step;
+    ASSERT_EQ(table.Depth(), reference.size());
+  }
+}
+
+TEST(LocalTable, DeepLetChain) {
+  constexpr int kDepth = 3000;
+  std::string body;
+  for (int i = 0; i < kDepth; ++i) {
+    body += "let x";
+    body += std::to_string(i);
+    body += " : Int <- ";
+    if (i == 0) {
+      body += "0";
+    } else {
+      body += "x";
+      body += std::to_string(i - 1);
+    }
+    body += " in\n";
+  }
+  EXPECT_TRUE(Compiles("class Main { main() : Int {\n" + body + "x" + std::to_string(kDepth - 1) + " }; };\n"));
+}
+
+TEST(InheritanceGraph, ReportsEveryClassReachingCycle) {
+  std::mt19937 random{11};
+  for (int round = 0; round < 50; ++round) {
+    std::vector<int> parents(1 + random() % 40);
+    for (auto& parent : parents) {
+      parent = static_cast<int>(random() % (parents.size() + 4)) - 4;
+    }
+    std::set<std::string> expected;
+    for (std::size_t i = 0; i < parents.size(); ++i) {
+      auto curr = static_cast<int>(i);
+      for (std::size_t steps = 0; curr >= 0 && steps <= parents.size(); ++steps) {
+        curr = parents[curr];
+      }
+      if (curr >= 0) {
+        std::string name{"H"};
+        name += std::to_string(i);
+        expected.insert("Class " + name + ", or an ancestor of " + name + ", is involved in an inheritance cycle.");
+      }
+    }
+    auto program = Hierarchy(parents);
+    coolc::InheritanceGraph graph;
+    testing::internal::CaptureStderr();
+    EXPECT_EQ(graph.FillAndCheck(program), expected.empty());
+    std::istringstream err{testing::internal::GetCapturedStderr()};
+    std::set<std::string> reported;
+    for (std::string line; std::getline(err, line);) {
+      EXPECT_TRUE(reported.insert(line).second) << line;
+    }
+    EXPECT_EQ(reported, expected) << "round " << round;
+  }
+}
+
+TEST(InheritanceGraph, HundredThousandClasses) {
+  constexpr int kSize = 100000;
+  std::vector<int> chain(kSize);
+  std::vector<int> wide(kSize);
+  for (int i = 0; i < kSize; ++i) {
+    chain[i] = i - 1;
+    wide[i] = i == 0 ? -1 : 0;
+  }
+  auto first = coolc::Symbol::Intern("H0");
+  auto last = coolc::Symbol::Intern("H" + std::to_string(kSize - 1));
+  {
+    auto program = Hierarchy(chain);
+    coolc::InheritanceGraph graph;
+    ASSERT_TRUE(graph.FillAndCheck(program));
+    EXPECT_EQ(graph.Depth(last), static_cast<std::size_t>(kSize));
+    EXPECT_TRUE(graph.IsAncessor(first, last));
+    EXPECT_EQ(graph.GetLca(last, coolc::symbols::kMain), coolc::symbols::kObject);
+  }
+  {
+    auto program = Hierarchy(wide);
+    coolc::InheritanceGraph graph;
+    ASSERT_TRUE(graph.FillAndCheck(program));
+    EXPECT_EQ(graph.Depth(last), 2u);
+    EXPECT_EQ(graph.GetLca(last, coolc::Symbol::Intern("H1")), first);
+  }
+  {
+    std::string source = "class H0 { f() : Int { 0 }; };\n";
+    for (int i = 1; i < kSize; ++i) {
+      source += "class H" + std::to_string(i) + " inherits H" + std::to_string(i - 1) + " {};\n";
+    }
+    source += "class Main { main() : Int { (new H" + std::to_string(kSize - 1) + ").f() }; };\n";
+    EXPECT_TRUE(Compiles(source));
+  }
+  {
+    // the whole chain hangs from a cycle of two classes
+    chain[0] = 1;
+    auto program = Hierarchy(chain);
+    coolc::InheritanceGraph graph;
+    testing::internal::CaptureStderr();
+    EXPECT_FALSE(graph.FillAndCheck(program));
+    auto err = testing::internal::GetCapturedStderr();
+    EXPECT_EQ(std::count(err.begin(), err.end(), '\n'), kSize);
+  }
+}
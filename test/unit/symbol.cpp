@@ -0,0 +1,87 @@
+#include "symbol/symbol.hpp"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using coolc::Symbol;
+
+TEST(Symbol, PredefinedSymbols) {
+  EXPECT_EQ(Symbol::Intern("Object"), coolc::symbols::kObject);
+  EXPECT_EQ(Symbol::Intern("SELF_TYPE"), coolc::symbols::kSelfType);
+  EXPECT_EQ(Symbol::Intern(""), coolc::symbols::kEmpty);
+  EXPECT_EQ(coolc::symbols::kNoType.View(), "_no_type");
+  EXPECT_EQ(Symbol{}, coolc::symbols::kEmpty);
+}
+
+TEST(Symbol, InternIsIdempotent) {
+  auto foo = Symbol::Intern("foo");
+  std::string text = "fo";
+  text.push_back('o');
+  EXPECT_EQ(Symbol::Intern(text), foo);
+  EXPECT_NE(Symbol::Intern("Foo"), foo);
+  EXPECT_EQ(foo.View(), "foo");
+  EXPECT_EQ(foo.Str(), "foo");
+  // text is stored in the table, not referenced
+  text = "bar";
+  EXPECT_EQ(foo.View(), "foo");
+}
+
+TEST(Symbol, ConcurrentIntern) {
+  constexpr int kThreads = 4;
+  constexpr int kSymbols = 20000;
+  std::vector<std::vector<Symbol>> results(kThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([t, &results] {
+      for (int i = 0; i < kSymbols; ++i) {
+        results[t].push_back(Symbol::Intern("concurrent_" + std::to_string(i)));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  std::unordered_set<Symbol> unique(results[0].begin(), results[0].end());
+  EXPECT_EQ(unique.size(), kSymbols);
+  for (int t = 1; t < kThreads; ++t) {
+    EXPECT_EQ(results[t], results[0]);
+  }
+  for (int i = 0; i < kSymbols; ++i) {
+    EXPECT_EQ(results[0][i].View(), "concurrent_" + std::to_string(i));
+  }
+}
+
+TEST(Symbol, LookupsDuringGrowth) {
+  constexpr int kReaders = 3;
+  constexpr int kSymbols = 50000;
+  auto known = Symbol::Intern("known_before_growth");
+  std::atomic<bool> done{false};
+  std::atomic<int> mismatches{0};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < kReaders; ++t) {
+    readers.emplace_back([&] {
+      while (!done.load()) {
+        if (Symbol::Intern("known_before_growth") != known || Symbol::Intern("Object") != coolc::symbols::kObject) {
+          ++mismatches;
+        }
+      }
+    });
+  }
+  std::vector<Symbol> grown;
+  for (int i = 0; i < kSymbols; ++i) {
+    grown.push_back(Symbol::Intern("growth_" + std::to_string(i)));
+  }
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(mismatches.load(), 0);
+  for (int i = 0; i < kSymbols; ++i) {
+    EXPECT_EQ(Symbol::Intern("growth_" + std::to_string(i)), grown[i]);
+  }
+}